@@ -0,0 +1,253 @@
+// Headless layout/animation benchmark. Builds styles.cpp and animvar.hpp against
+// the stubs in bench/stubs so it runs on any Linux box without a compositor.
+#include "animvar.hpp"
+#include "occlusion.hpp"
+#include "styles.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+
+namespace {
+
+constexpr size_t COUNTS[] = {8, 64, 512, 4096};
+constexpr double TARGET_NS = 50'000'000.0; // run each case for ~50ms
+
+volatile float sink = 0.0f;
+
+void setDefaults() {
+#define X(type, name, conf, def) Config::name = def;
+  CONFIG_VARS
+#undef X
+}
+
+StyleContext makeContext(size_t count, float rotation) {
+  const Vector2D mSize = {2560, 1440};
+  const float invCount = 1.0f / (float)count;
+  const float r = mSize.x * 0.5f;
+  return {
+      .count = count,
+      .active = count / 3,
+      .invCount = invCount,
+      .angleStep = (2.0f * (float)M_PI) * invCount,
+      .mSize = mSize,
+      .midpoint = mSize * 0.5f,
+      .radius = r,
+      .tiltOffset = r * std::sin(Config::tilt * ((float)M_PI / 180.0f)),
+      .rotation = rotation,
+      .scale = 1.0f,
+      .alpha = 1.0f,
+      .activeProgress = 0.5f};
+}
+
+Vector2D surfaceFor(size_t i) {
+  return {1280.0 + (i % 7) * 120.0, 720.0 + (i % 5) * 90.0};
+}
+
+// Returns ns per unit of work, where fn performs `units` units per call
+double measure(size_t units, const std::function<void()> &fn) {
+  using clock = std::chrono::steady_clock;
+  fn();
+  size_t iterations = 1;
+  while (true) {
+    const auto start = clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+      fn();
+    const double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    if (ns >= TARGET_NS || iterations >= (1u << 30))
+      return ns / (double)(iterations * units);
+    iterations *= 2;
+  }
+}
+
+void benchStyle(const char *name, IStyle &style) {
+  for (const size_t count : COUNTS) {
+    StyleBatch batch;
+    batch.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      const auto surf = surfaceFor(i);
+      batch.width[i] = surf.x;
+      batch.height[i] = surf.y;
+      batch.index[i] = (float)i;
+    }
+
+    float rotation = 0.0f;
+    const double scalar = measure(count, [&] {
+      const auto ctx = makeContext(count, rotation += 0.001f);
+      float acc = 0.0f;
+      for (size_t i = 0; i < count; ++i) {
+        const auto data = style.calculate(ctx, surfaceFor(i), i);
+        acc += data.position.x + data.z;
+      }
+      sink = sink + acc;
+    });
+
+    const double batched = measure(count, [&] {
+      const auto ctx = makeContext(count, rotation += 0.001f);
+      style.calculateBatch(ctx, batch);
+      sink = sink + batch.x[count - 1];
+    });
+
+    size_t index = 0;
+    const double move = measure(1, [&] {
+      const auto res = style.onMove(Direction::RIGHT, index, count);
+      index = res.index.value_or(0);
+      sink = sink + (float)index;
+    });
+
+    // Deviation of the vector kernel from the scalar reference, in pixels
+    const auto ctx = makeContext(count, 1.2345f);
+    style.calculateBatch(ctx, batch);
+    double maxErr = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+      const auto ref = style.calculate(ctx, surfaceFor(i), i);
+      if (!ref.visible || batch.visible[i] == 0.0f)
+        continue;
+      maxErr = std::max({maxErr,
+                         std::abs(ref.position.x - batch.x[i]), std::abs(ref.position.y - batch.y[i]),
+                         std::abs(ref.position.width - batch.w[i]), std::abs(ref.position.height - batch.h[i])});
+    }
+
+    std::printf("%-10s %6zu  calculate %8.2f ns/card  batch %8.2f ns/card  onMove %8.2f ns  max err %.3f px\n",
+                name, count, scalar, batched, move, maxErr);
+  }
+}
+
+void benchAnimations() {
+  for (const size_t count : COUNTS) {
+    std::vector<std::unique_ptr<AnimatedValue<float>>> values;
+    values.reserve(count);
+
+    // Create and destroy the whole set, per value
+    const double churn = measure(count, [&] {
+      for (size_t i = 0; i < count; ++i)
+        values.emplace_back(std::make_unique<AnimatedValue<float>>(&Config::rotationSpeed));
+      values.clear();
+    });
+
+    for (size_t i = 0; i < count; ++i) {
+      values.emplace_back(std::make_unique<AnimatedValue<float>>(&Config::rotationSpeed));
+      values.back()->set((float)i);
+    }
+
+    // Sampling right at the start keeps every value in flight for the whole run
+    const auto start = NOW;
+    const double live = measure(count, [&] {
+      sink = sink + (float)AnimationManager::get().tick(start);
+    });
+
+    for (auto &v : values)
+      v->snap(v->target());
+    const double idle = measure(count, [&] {
+      sink = sink + (float)AnimationManager::get().tick(NOW);
+    });
+
+    std::printf("%-10s %6zu  tick live %8.2f ns/value  tick idle %8.2f ns/value  create+destroy %8.2f ns/value\n",
+                "animation", count, live, idle, churn);
+  }
+}
+
+// Exact visibility from a 1px coverage raster, only used to check the grid
+std::vector<float> rasterVisibility(const std::vector<CBox> &boxes, const CBox &bounds) {
+  const int w = (int)bounds.w, h = (int)bounds.h;
+  std::vector<uint8_t> covered((size_t)w * h, 0);
+  std::vector<float> out;
+  for (const auto &box : boxes) {
+    const int x0 = std::max(0, (int)(box.x - bounds.x)), x1 = std::min(w, (int)(box.x + box.w - bounds.x));
+    const int y0 = std::max(0, (int)(box.y - bounds.y)), y1 = std::min(h, (int)(box.y + box.h - bounds.y));
+    size_t hidden = 0;
+    for (int y = y0; y < y1; ++y)
+      for (int x = x0; x < x1; ++x) {
+        hidden += covered[(size_t)y * w + x];
+        covered[(size_t)y * w + x] = 1;
+      }
+    out.push_back(1.0f - (float)hidden / (float)(box.w * box.h));
+  }
+  return out;
+}
+
+void benchOcclusion() {
+  Carousel style;
+  for (const size_t count : COUNTS) {
+    StyleBatch batch;
+    batch.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      const auto surf = surfaceFor(i);
+      batch.width[i] = surf.x;
+      batch.height[i] = surf.y;
+      batch.index[i] = (float)i;
+    }
+    style.calculateBatch(makeContext(count, 1.2345f), batch);
+
+    // Front to back, like Monitor::update
+    std::vector<size_t> order(count);
+    for (size_t i = 0; i < count; ++i)
+      order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return batch.z[a] > batch.z[b]; });
+
+    std::vector<CBox> boxes;
+    double x1 = 1e9, y1 = 1e9, x2 = -1e9, y2 = -1e9;
+    for (const size_t i : order) {
+      CBox box{batch.x[i], batch.y[i], batch.w[i], batch.h[i]};
+      box.round();
+      if (box.w <= 0 || box.h <= 0)
+        continue;
+      boxes.push_back(box);
+      x1 = std::min(x1, box.x);
+      y1 = std::min(y1, box.y);
+      x2 = std::max(x2, box.x + box.w);
+      y2 = std::max(y2, box.y + box.h);
+    }
+    const CBox bounds{x1, y1, x2 - x1, y2 - y1};
+
+    OcclusionGrid grid;
+    const double perCard = measure(boxes.size(), [&] {
+      grid.reset(bounds);
+      float acc = 0.0f;
+      for (const auto &box : boxes)
+        acc += grid.cover(box);
+      sink = sink + acc;
+    });
+
+    double maxErr = 0.0;
+    if (count <= 512) {
+      const auto exact = rasterVisibility(boxes, bounds);
+      grid.reset(bounds);
+      for (size_t i = 0; i < boxes.size(); ++i)
+        maxErr = std::max(maxErr, (double)std::abs(grid.cover(boxes[i]) - exact[i]));
+    }
+
+    std::printf("%-10s %6zu  grid %8.2f ns/card  max visibility err %.3f%s\n", "occlusion", count, perCard, maxErr,
+                count <= 512 ? "" : " (unchecked)");
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  setDefaults();
+
+  const char *only = argc > 1 ? argv[1] : nullptr;
+  auto wants = [&](const char *name) { return !only || std::strcmp(only, name) == 0; };
+
+  if (wants("carousel")) {
+    Carousel style;
+    benchStyle("carousel", style);
+  }
+  if (wants("grid")) {
+    Grid style;
+    benchStyle("grid", style);
+  }
+  if (wants("slide")) {
+    Slide style;
+    benchStyle("slide", style);
+  }
+  if (wants("animation"))
+    benchAnimations();
+  if (wants("occlusion"))
+    benchOcclusion();
+
+  return 0;
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <cstdint>
+
+namespace Hyprlang {
+typedef int64_t INT;
+typedef float FLOAT;
+typedef const char *STRING;
+} // namespace Hyprlang
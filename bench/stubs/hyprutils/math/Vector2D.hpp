@@ -0,0 +1,62 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+class Vector2D {
+public:
+  Vector2D() = default;
+  Vector2D(double x, double y) : x(x), y(y) {}
+
+  Vector2D operator+(const Vector2D &o) const { return {x + o.x, y + o.y}; }
+  Vector2D operator-(const Vector2D &o) const { return {x - o.x, y - o.y}; }
+  Vector2D operator*(double s) const { return {x * s, y * s}; }
+  Vector2D operator/(double s) const { return {x / s, y / s}; }
+  bool operator==(const Vector2D &o) const { return x == o.x && y == o.y; }
+
+  double x = 0, y = 0;
+};
+
+class CBox {
+public:
+  CBox() = default;
+  CBox(double x, double y, double w, double h) : x(x), y(y), w(w), h(h) {}
+  CBox(const Vector2D &pos, const Vector2D &size) : x(pos.x), y(pos.y), w(size.x), h(size.y) {}
+
+  bool overlaps(const CBox &o) const {
+    return (o.x + o.w >= x) && (x + w >= o.x) && (o.y + o.h >= y) && (y + h >= o.y);
+  }
+  bool empty() const { return w <= 0 || h <= 0; }
+  Vector2D pos() const { return {x, y}; }
+  Vector2D size() const { return {w, h}; }
+  CBox copy() const { return *this; }
+  CBox &translate(const Vector2D &v) {
+    x += v.x;
+    y += v.y;
+    return *this;
+  }
+  CBox &round() {
+    const double x2 = std::round(x + w), y2 = std::round(y + h);
+    x = std::round(x);
+    y = std::round(y);
+    w = x2 - x;
+    h = y2 - y;
+    return *this;
+  }
+  CBox &expand(double v) {
+    x -= v;
+    y -= v;
+    w += v * 2;
+    h += v * 2;
+    return *this;
+  }
+
+  double x = 0, y = 0;
+  union {
+    double w = 0;
+    double width;
+  };
+  union {
+    double h = 0;
+    double height;
+  };
+};
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdio>
+#include <ctime>
+
+namespace Hyprutils::CLI {
+enum eLogLevel {
+  LOG_TRACE,
+  LOG_DEBUG,
+  LOG_WARN,
+  LOG_ERR,
+};
+} // namespace Hyprutils::CLI
+
+namespace Log {
+inline constexpr auto WARN = Hyprutils::CLI::LOG_WARN;
+inline constexpr auto ERR = Hyprutils::CLI::LOG_ERR;
+
+struct CLogger {
+  template <typename... Args>
+  void log(Hyprutils::CLI::eLogLevel, const char *, Args &&...) {}
+};
+inline CLogger *logger = nullptr;
+} // namespace Log
@@ -0,0 +1,12 @@
+#pragma once
+#include "../helpers/memory/Memory.hpp"
+#include <chrono>
+#include <hyprutils/math/Vector2D.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+
+class CMonitor;
+class CWindow;
+using PHLMONITOR = SP<CMonitor>;
+using PHLWINDOW = SP<CWindow>;
@@ -0,0 +1,18 @@
+#pragma once
+#include <memory>
+
+template <typename T>
+using UP = std::unique_ptr<T>;
+template <typename T>
+using SP = std::shared_ptr<T>;
+template <typename T>
+using WP = std::weak_ptr<T>;
+
+template <typename T, typename... Args>
+UP<T> makeUnique(Args &&...args) {
+  return std::make_unique<T>(std::forward<Args>(args)...);
+}
+template <typename T, typename... Args>
+SP<T> makeShared(Args &&...args) {
+  return std::make_shared<T>(std::forward<Args>(args)...);
+}
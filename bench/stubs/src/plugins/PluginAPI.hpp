@@ -0,0 +1,4 @@
+#pragma once
+#include <hyprlang.hpp>
+
+typedef void *HANDLE;
@@ -1,95 +1,313 @@
 #pragma once
+#include "defines.hpp"
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
 #include <hyprlang.hpp>
 #include <src/helpers/memory/Memory.hpp>
 #include <vector>
 
-class IAnimatedValue;
+// Easing curve baked into a table, progress in [0, 1] -> eased value. Evaluating it is a
+// lerp between two entries, whatever the curve (bezier solves happen only when baking).
+struct CurveLUT {
+  static constexpr int SIZE = 128;
+  std::array<float, SIZE + 1> y;
+
+  CurveLUT() {
+    reset();
+  }
+
+  void bake(const std::function<float(float)> &fn) {
+    for (int i = 0; i <= SIZE; ++i)
+      y[i] = fn((float)i / SIZE);
+    y[0] = 0.0f;
+    y[SIZE] = 1.0f;
+  }
+
+  // Ease-out quad, what everything used before curves were configurable
+  void reset() {
+    bake([](float t) { return t * (2.0f - t); });
+  }
+
+  float operator()(float t) const {
+    const float f = t * SIZE;
+    const int i = std::min((int)f, SIZE - 1);
+    return y[i] + (y[i + 1] - y[i]) * (f - (float)i);
+  }
+
+  // dy/dt at t
+  float slope(float t) const {
+    const int i = std::clamp((int)(t * SIZE), 0, SIZE - 1);
+    return (y[i + 1] - y[i]) * SIZE;
+  }
+
+  // First t where the slope relative to what's left of the curve, y'(t) / (1 - y(t)), reaches
+  // ratio. Starting there continues a motion at that speed, 0 if the curve is never that steep.
+  float matchSlope(float ratio) const {
+    for (int i = 0; i < SIZE; ++i) {
+      const float left = 1.0f - y[i];
+      if (left > 1e-4f && (y[i + 1] - y[i]) * SIZE >= ratio * left)
+        return (float)i / SIZE;
+    }
+    return 0.0f;
+  }
+
+  static const CurveLUT &standard() {
+    static const CurveLUT curve;
+    return curve;
+  }
+};
+
+// Baked from the *_curve options on config reload
+namespace Curves {
+inline CurveLUT rotation;
+inline CurveLUT monitor;
+inline CurveLUT fade;
+} // namespace Curves
+
+// Every animated float lives in one pool of parallel arrays. Values in flight are kept packed
+// at the front, so tick() is a straight loop over just those and finished values cost nothing.
+// AnimatedValue only holds a handle, creating and destroying one is O(1).
+//
+// Values are a function of time since their start, not integrated per frame: tick() samples
+// them at the time the frame will be on screen, so uneven render callbacks don't add up and
+// each output can sample the same animation at its own vblank.
 class AnimationManager {
 public:
-  void add(IAnimatedValue *val);
-  void remove(IAnimatedValue *val);
-  bool tick(const float delta);
+  using Handle = uint32_t;
+
+  Handle create(Hyprlang::FLOAT *speed, const CurveLUT *curve);
+  void destroy(Handle handle);
+  void set(Handle handle, float val, bool snap, Timestamp at);
+  // Samples everything in flight at `at`, usually the predicted presentation time
+  bool tick(Timestamp at);
+
+  float current(Handle handle) const {
+    return cur[slot[handle]];
+  }
+  float target(Handle handle) const {
+    return end[slot[handle]];
+  }
+  float progress(Handle handle) const {
+    return prog[slot[handle]];
+  }
+  size_t inFlight() const {
+    return active;
+  }
+
   static AnimationManager &get() {
     static AnimationManager instance;
     return instance;
   }
 
 private:
-  std::vector<IAnimatedValue *> variables;
-  bool animating = false;
-};
+  void swap(uint32_t a, uint32_t b);
+  void start(uint32_t i);
+  void finish(uint32_t i);
+  float sample(uint32_t i, double t) const;
 
-class IAnimatedValue {
-public:
-  IAnimatedValue() {
-    AnimationManager::get().add(this);
-  };
-  ~IAnimatedValue() {
-    AnimationManager::get().remove(this);
-  }
-  virtual void tick(float delta) = 0;
-  virtual bool done() = 0;
+  static double seconds(Timestamp at) {
+    static const Timestamp epoch = NOW;
+    return std::chrono::duration<double>(at - epoch).count();
+  }
+
+  // Indexed by pool position, [0, active) are in flight
+  std::vector<float> begin, end, cur, prog;
+  // 1 / duration, taken from the speed setting when the animation starts
+  std::vector<float> rate;
+  // Start time in seconds()
+  std::vector<double> startAt;
+  std::vector<Hyprlang::FLOAT *> speed;
+  std::vector<const CurveLUT *> curve;
+  std::vector<Handle> owner;
+  uint32_t active = 0;
+
+  // Handle -> pool position
+  std::vector<uint32_t> slot;
+  std::vector<Handle> freeHandles;
 };
 
 template <typename T>
-struct AnimatedValue : public IAnimatedValue {
-  T current{};
-  T start{};
-  T target{};
-  float progress = 1.0f;
-  Hyprlang::FLOAT *speed = nullptr;
+class AnimatedValue;
 
-  AnimatedValue(auto *speed) : speed(speed) {}
+// Eased float, the state is in AnimationManager
+template <>
+class AnimatedValue<float> {
+public:
+  AnimatedValue(Hyprlang::FLOAT *speed, const CurveLUT *curve = &CurveLUT::standard()) : handle(AnimationManager::get().create(speed, curve)) {}
+  ~AnimatedValue() {
+    AnimationManager::get().destroy(handle);
+  }
+  AnimatedValue(const AnimatedValue &) = delete;
+  AnimatedValue &operator=(const AnimatedValue &) = delete;
 
-  AnimatedValue &operator=(const T &val) {
+  AnimatedValue &operator=(float val) {
     set(val, false);
     return *this;
   }
 
-  void snap(T val) {
+  void snap(float val) {
     set(val, true);
   }
 
-  void set(T val, bool snap = false) {
-    if (snap) {
-      current = start = target = val;
-      progress = 1.0f;
-    } else if (val != target) {
-      start = current;
-      target = val;
-      progress = 0.0f;
-    }
+  void set(float val, bool snap = false) {
+    AnimationManager::get().set(handle, val, snap, NOW);
   }
 
-  void tick(float delta) {
-    if (progress >= 1.0f) {
-      current = target;
-      return;
-    }
-    progress = std::min(1.0f, progress + (delta / std::max(0.01f, *speed)));
-    float t = progress * (2.0f - progress);
-    current = start + (target - start) * t;
+  float current() const {
+    return AnimationManager::get().current(handle);
   }
-
-  bool done() {
-    return progress >= 1.0f;
+  float target() const {
+    return AnimationManager::get().target(handle);
+  }
+  float progress() const {
+    return AnimationManager::get().progress(handle);
   }
+  bool done() const {
+    return progress() >= 1.0f;
+  }
+
+private:
+  AnimationManager::Handle handle;
 };
 
-inline void AnimationManager::add(IAnimatedValue *val) {
-  if (std::find(variables.begin(), variables.end(), val) == variables.end()) {
-    variables.emplace_back(val);
+inline AnimationManager::Handle AnimationManager::create(Hyprlang::FLOAT *spd, const CurveLUT *crv) {
+  Handle handle;
+  if (!freeHandles.empty()) {
+    handle = freeHandles.back();
+    freeHandles.pop_back();
+  } else {
+    handle = (Handle)slot.size();
+    slot.emplace_back();
   }
+
+  const uint32_t i = (uint32_t)cur.size();
+  begin.push_back(0.0f);
+  end.push_back(0.0f);
+  cur.push_back(0.0f);
+  prog.push_back(1.0f);
+  rate.push_back(1.0f);
+  startAt.push_back(0.0);
+  speed.push_back(spd);
+  curve.push_back(crv);
+  owner.push_back(handle);
+  slot[handle] = i;
+  return handle;
 }
-inline void AnimationManager::remove(IAnimatedValue *val) {
-  std::erase(variables, val);
-};
-inline bool AnimationManager::tick(const float delta) {
-  animating = false;
-  for (auto &var : variables) {
-    var->tick(delta);
-    animating |= !var->done();
+
+inline void AnimationManager::destroy(Handle handle) {
+  uint32_t i = slot[handle];
+  if (i < active)
+    finish(i);
+  i = slot[handle];
+  swap(i, (uint32_t)cur.size() - 1);
+
+  begin.pop_back();
+  end.pop_back();
+  cur.pop_back();
+  prog.pop_back();
+  rate.pop_back();
+  startAt.pop_back();
+  speed.pop_back();
+  curve.pop_back();
+  owner.pop_back();
+  freeHandles.push_back(handle);
+}
+
+inline float AnimationManager::sample(uint32_t i, double t) const {
+  const float p = std::clamp((float)(t - startAt[i]) * rate[i], 0.0f, 1.0f);
+  return begin[i] + (end[i] - begin[i]) * (*curve[i])(p);
+}
+
+inline void AnimationManager::set(Handle handle, float val, bool snap, Timestamp at) {
+  const uint32_t i = slot[handle];
+  if (snap) {
+    cur[i] = begin[i] = end[i] = val;
+    prog[i] = 1.0f;
+    if (i < active)
+      finish(i);
+  } else if (val != end[i]) {
+    // Retarget from where it is right now, not where the last frame showed it
+    const double t = seconds(at);
+    const bool moving = i < active;
+    const float from = moving ? sample(i, t) : cur[i];
+    const CurveLUT &k = *curve[i];
+    float newRate = 1.0f / std::max(0.01f, (float)*speed[i]);
+    float p0 = 0.0f;
+    if (moving) {
+      // Keep the current speed: enter the new curve where its slope matches, instead of
+      // restarting the easing (which is what made held keys stutter)
+      const float p = std::clamp((float)(t - startAt[i]) * rate[i], 0.0f, 1.0f);
+      const float velocity = (end[i] - begin[i]) * k.slope(p) * rate[i];
+      const float distance = val - from;
+      if (distance != 0.0f && velocity / distance > 0.0f) {
+        const float ratio = velocity / (distance * newRate);
+        if (ratio >= k.slope(0.0f))
+          p0 = std::min(k.matchSlope(ratio), 0.9f); // the tail is too flat to aim with
+        else
+          // Slower than the curve ever starts: stretch it instead, up to twice as long
+          newRate = std::max(newRate * 0.5f, velocity / (distance * k.slope(0.0f)));
+      }
+    }
+    rate[i] = newRate;
+    // begin is where the curve would have started for `from` to sit at p0
+    const float y0 = k(p0);
+    begin[i] = y0 < 1.0f ? (from - val * y0) / (1.0f - y0) : from;
+    end[i] = val;
+    prog[i] = p0;
+    startAt[i] = t - p0 / rate[i];
+    if (!moving)
+      start(i);
+  }
+}
+
+inline bool AnimationManager::tick(Timestamp at) {
+  // Straight loop over packed arrays, the curve lookup is the only gather
+  const uint32_t n = active;
+  const double now = seconds(at);
+  float *__restrict b = begin.data();
+  float *__restrict e = end.data();
+  float *__restrict c = cur.data();
+  float *__restrict p = prog.data();
+  const float *__restrict r = rate.data();
+  const double *__restrict s = startAt.data();
+  const CurveLUT *const *__restrict k = curve.data();
+  for (uint32_t i = 0; i < n; ++i) {
+    p[i] = std::clamp((float)(now - s[i]) * r[i], 0.0f, 1.0f);
+    c[i] = b[i] + (e[i] - b[i]) * (*k[i])(p[i]);
   }
-  return animating;
+
+  // Finished ones move out of the packed range, walking backwards keeps the swaps valid
+  for (uint32_t i = n; i-- > 0;) {
+    if (p[i] >= 1.0f) {
+      c[i] = e[i];
+      finish(i);
+    }
+  }
+  return active > 0;
+}
+
+inline void AnimationManager::swap(uint32_t a, uint32_t b) {
+  if (a == b)
+    return;
+  std::swap(begin[a], begin[b]);
+  std::swap(end[a], end[b]);
+  std::swap(cur[a], cur[b]);
+  std::swap(prog[a], prog[b]);
+  std::swap(rate[a], rate[b]);
+  std::swap(startAt[a], startAt[b]);
+  std::swap(speed[a], speed[b]);
+  std::swap(curve[a], curve[b]);
+  std::swap(owner[a], owner[b]);
+  slot[owner[a]] = a;
+  slot[owner[b]] = b;
+}
+
+inline void AnimationManager::start(uint32_t i) {
+  swap(i, active++);
+}
+
+inline void AnimationManager::finish(uint32_t i) {
+  swap(i, --active);
 }
@@ -0,0 +1,302 @@
+#include "background.hpp"
+#include "cardshader.hpp"
+#include "logger.hpp"
+#include <cmath>
+#include <hyprutils/math/Vector2D.hpp>
+
+#define private public
+#define protected public
+#include <src/render/OpenGL.hpp>
+#include <src/render/Renderer.hpp>
+#undef protected
+#undef private
+
+#include <src/Compositor.hpp>
+#include <src/config/ConfigValue.hpp>
+#include <src/desktop/view/Window.hpp>
+#include <src/helpers/Monitor.hpp>
+
+using namespace alttab;
+
+void Background::capture(PHLMONITOR monitor) {
+  LOG_SCOPE()
+  if (monitor->m_pixelSize.x <= 0 || monitor->m_pixelSize.y <= 0)
+    return;
+
+  if (!fb)
+    fb = makeShared<CFramebuffer>();
+  if (!fb->isAllocated() || size != monitor->m_pixelSize || format != monitor->m_drmFormat)
+    fb->alloc(monitor->m_pixelSize.x, monitor->m_pixelSize.y, monitor->m_drmFormat);
+  size = monitor->m_pixelSize;
+  format = monitor->m_drmFormat;
+  workspace = monitor->m_activeWorkspace ? monitor->m_activeWorkspace->m_id : WORKSPACE_INVALID;
+
+  CRegion fullRegion = CBox({0, 0}, monitor->m_pixelSize);
+
+  OVERRIDE_WORKSPACE = false;
+  g_pHyprRenderer->beginRender(monitor, fullRegion, RENDER_MODE_FULL_FAKE, {}, fb.get());
+  g_pHyprRenderer->renderWorkspace(monitor, monitor->m_activeWorkspace, Time::steadyNow(), fullRegion.getExtents());
+  g_pHyprRenderer->m_renderPass.render(fullRegion);
+  g_pHyprRenderer->m_renderPass.clear();
+  g_pHyprRenderer->endRender();
+  OVERRIDE_WORKSPACE = true;
+
+  texture = fb->getTexture();
+  blurred.reset();
+  stale = false;
+}
+
+// Dual kawase: each downsample halves the size and spreads the blur, the upsamples smooth it
+// out again. Quality only decides how far back up the result goes, since a strong blur looks
+// the same at 1/8 and 1/2 once stretched over the output.
+static const char *BLUR_VERT = R"#(#version 300 es
+in vec2 pos;
+out vec2 v_uv;
+
+void main() {
+  gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+  v_uv = pos;
+}
+)#";
+
+static const char *BLUR_DOWN = R"#(#version 300 es
+precision highp float;
+in vec2 v_uv;
+uniform sampler2D tex;
+uniform vec2 halfpixel;
+uniform float offset;
+out vec4 fragColor;
+
+void main() {
+  vec2 o = halfpixel * offset;
+  vec4 sum = texture(tex, v_uv) * 4.0;
+  sum += texture(tex, v_uv - o);
+  sum += texture(tex, v_uv + o);
+  sum += texture(tex, v_uv + vec2(o.x, -o.y));
+  sum += texture(tex, v_uv - vec2(o.x, -o.y));
+  fragColor = sum / 8.0;
+}
+)#";
+
+static const char *BLUR_UP = R"#(#version 300 es
+precision highp float;
+in vec2 v_uv;
+uniform sampler2D tex;
+uniform vec2 halfpixel;
+uniform float offset;
+out vec4 fragColor;
+
+void main() {
+  vec2 o = halfpixel * offset;
+  vec4 sum = texture(tex, v_uv + vec2(-o.x * 2.0, 0.0));
+  sum += texture(tex, v_uv + vec2(-o.x, o.y)) * 2.0;
+  sum += texture(tex, v_uv + vec2(0.0, o.y * 2.0));
+  sum += texture(tex, v_uv + vec2(o.x, o.y)) * 2.0;
+  sum += texture(tex, v_uv + vec2(o.x * 2.0, 0.0));
+  sum += texture(tex, v_uv + vec2(o.x, -o.y)) * 2.0;
+  sum += texture(tex, v_uv + vec2(0.0, -o.y * 2.0));
+  sum += texture(tex, v_uv + vec2(-o.x, -o.y)) * 2.0;
+  fragColor = sum / 12.0;
+}
+)#";
+
+namespace {
+struct BlurProgram {
+  GLuint program = 0;
+  GLint tex = -1;
+  GLint halfpixel = -1;
+  GLint offset = -1;
+};
+struct {
+  BlurProgram down, up;
+  GLuint vao = 0;
+  GLuint vbo = 0;
+  bool failed = false;
+} blurShaders;
+
+bool compileBlur(BlurProgram &prog, const char *frag) {
+  prog.program = compileProgram(BLUR_VERT, frag);
+  if (!prog.program)
+    return false;
+  prog.tex = glGetUniformLocation(prog.program, "tex");
+  prog.halfpixel = glGetUniformLocation(prog.program, "halfpixel");
+  prog.offset = glGetUniformLocation(prog.program, "offset");
+  return true;
+}
+
+bool ensureBlurShaders() {
+  if (blurShaders.vao)
+    return true;
+  if (blurShaders.failed)
+    return false;
+  if (!compileBlur(blurShaders.down, BLUR_DOWN) || !compileBlur(blurShaders.up, BLUR_UP)) {
+    blurShaders.failed = true;
+    return false;
+  }
+  blurShaders.vao = createUnitQuad(blurShaders.vbo);
+  return true;
+}
+
+Vector2D levelSize(const Vector2D &size, int level) {
+  return {std::max(1.0, std::floor(size.x / (1 << level))), std::max(1.0, std::floor(size.y / (1 << level)))};
+}
+
+// One pass from src into dst, sampled with its neighbours at offset texels
+void blurPass(const BlurProgram &prog, const SP<CTexture> &src, const Vector2D &srcSize, CFramebuffer &dst, float offset) {
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst.getFBID());
+  glViewport(0, 0, dst.m_size.x, dst.m_size.y);
+  g_pHyprOpenGL->useProgram(prog.program);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(src->m_target, src->m_texID);
+  glTexParameteri(src->m_target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(src->m_target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(src->m_target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(src->m_target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glUniform1i(prog.tex, 0);
+  glUniform2f(prog.halfpixel, 0.5f / srcSize.x, 0.5f / srcSize.y);
+  glUniform1f(prog.offset, offset);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glBindTexture(src->m_target, 0);
+}
+} // namespace
+
+// Down levels grow with the output so the blur looks alike everywhere: 1 at 720p, 2 at
+// 1080p/1440p, 3 at 4K. Quality is how many of them the result climbs back up.
+void Background::blurLevels(const Vector2D &size, int &down, int &stored) {
+  down = std::clamp((int)std::ceil(std::log2(std::max(size.y, 1.0) / 360.0)), 1, 3);
+  stored = std::max(down - std::clamp((int)Config::blurQuality, 0, 2), 1);
+}
+
+void Background::blur(PHLMONITOR monitor) {
+  LOG_SCOPE()
+  if (!texture)
+    return;
+
+  g_pHyprOpenGL->makeEGLCurrent();
+  if (!ensureBlurShaders())
+    return;
+
+  int down = 1, stored = 1;
+  blurLevels(size, down, stored);
+
+  // Pyramid levels only live for this blur, the stored one is kept in blurFb
+  std::vector<SP<CFramebuffer>> levels(down + 1);
+  for (int i = 1; i <= down; ++i) {
+    auto &fb = (i == stored) ? blurFb : levels[i];
+    if (!fb)
+      fb = makeShared<CFramebuffer>();
+    const auto LEVEL = levelSize(size, i);
+    if (!fb->isAllocated() || fb->m_size != LEVEL)
+      fb->alloc(LEVEL.x, LEVEL.y, format);
+    levels[i] = fb;
+  }
+  LOG(Log::BACKGROUND, "blur {} levels down, stored at 1/{}", down, 1 << stored);
+
+  static auto PBLURSIZE = CConfigValue<Hyprlang::INT>("decoration:blur:size");
+  const float offset = std::clamp((float)*PBLURSIZE / 4.0f, 1.0f, 4.0f);
+
+  GLint prevFb = 0;
+  GLint prevViewport[4] = {};
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prevFb);
+  glGetIntegerv(GL_VIEWPORT, prevViewport);
+  g_pHyprOpenGL->scissor(nullptr);
+  g_pHyprOpenGL->blend(false);
+  glBindVertexArray(blurShaders.vao);
+
+  SP<CTexture> src = texture;
+  Vector2D srcSize = size;
+  for (int i = 1; i <= down; ++i) {
+    blurPass(blurShaders.down, src, srcSize, *levels[i], offset);
+    src = levels[i]->getTexture();
+    srcSize = levels[i]->m_size;
+  }
+  for (int i = down - 1; i >= stored; --i) {
+    blurPass(blurShaders.up, src, srcSize, *levels[i], offset);
+    src = levels[i]->getTexture();
+    srcSize = levels[i]->m_size;
+  }
+
+  glBindVertexArray(0);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, prevFb);
+  glViewport(prevViewport[0], prevViewport[1], prevViewport[2], prevViewport[3]);
+  g_pHyprOpenGL->blend(true);
+
+  blurred = blurFb->getTexture();
+  blurKey = BackgroundCache::blurSettingsKey();
+}
+
+void Background::destroy() {
+  for (auto *prog : {&blurShaders.down, &blurShaders.up})
+    if (prog->program)
+      glDeleteProgram(prog->program);
+  if (blurShaders.vbo)
+    glDeleteBuffers(1, &blurShaders.vbo);
+  if (blurShaders.vao)
+    glDeleteVertexArrays(1, &blurShaders.vao);
+  blurShaders = {};
+}
+
+bool Background::captured() const {
+  return texture != nullptr;
+}
+
+bool Background::ready() const {
+  return texture && (!Config::blurBG || blurred);
+}
+
+SP<Background> BackgroundCache::get(PHLMONITOR monitor) {
+  std::erase_if(entries, [](const auto &e) { return !g_pCompositor->getMonitorFromID(e.first); });
+
+  auto &bg = entries[monitor->m_id];
+  if (!bg)
+    bg = makeShared<Background>();
+
+  const auto WORKSPACE = monitor->m_activeWorkspace ? monitor->m_activeWorkspace->m_id : WORKSPACE_INVALID;
+  if (bg->stale || bg->workspace != WORKSPACE || bg->size != monitor->m_pixelSize || bg->format != monitor->m_drmFormat) {
+    LOG(Log::BACKGROUND, "background for monitor {} needs capture", monitor->m_id);
+    bg->texture.reset();
+    bg->blurred.reset();
+  } else if (bg->blurKey != blurSettingsKey())
+    bg->blurred.reset();
+
+  return bg;
+}
+
+void BackgroundCache::invalidate(PHLMONITOR monitor) {
+  if (!monitor)
+    return;
+  if (auto it = entries.find(monitor->m_id); it != entries.end())
+    it->second->stale = true;
+}
+
+void BackgroundCache::invalidate(PHLWINDOW window) {
+  if (!window || !window->m_workspace)
+    return;
+  const auto MONITOR = window->m_monitor.lock();
+  if (!MONITOR)
+    return;
+  if (window->m_workspace == MONITOR->m_activeWorkspace || window->m_workspace == MONITOR->m_activeSpecialWorkspace)
+    invalidate(MONITOR);
+}
+
+void BackgroundCache::onFrameDamage(PHLMONITOR monitor, const CRegion &damage) {
+  if (!monitor || damage.empty())
+    return;
+  if (settling.erase(monitor->m_id))
+    return;
+  invalidate(monitor);
+}
+
+void BackgroundCache::settle(MONITORID id) {
+  settling.insert(id);
+}
+
+void BackgroundCache::clear() {
+  entries.clear();
+  settling.clear();
+}
+
+int BackgroundCache::blurSettingsKey() {
+  static auto PBLURSIZE = CConfigValue<Hyprlang::INT>("decoration:blur:size");
+  return (int)(Config::blurBG ? 1 : 0) | (int)(*PBLURSIZE << 1) | (int)(Config::blurQuality << 16);
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "defines.hpp"
+#include <map>
+#include <set>
+#include <src/desktop/DesktopTypes.hpp>
+#include <src/render/Framebuffer.hpp>
+
+namespace alttab {
+
+// Captured (and optionally blurred) workspace background of one output.
+// Framebuffers stay allocated between activations, textures are only redone when stale.
+// The blurred copy is a fraction of the output size, see blurLevels().
+struct Background {
+  WORKSPACEID workspace = WORKSPACE_INVALID;
+  Vector2D size;
+  uint32_t format = 0;
+  int blurKey = -1;
+  bool stale = true;
+
+  SP<CFramebuffer> fb, blurFb;
+  SP<CTexture> texture, blurred;
+
+  void capture(PHLMONITOR monitor);
+  void blur(PHLMONITOR monitor);
+  bool captured() const;
+  bool ready() const;
+
+  // Pyramid depth for an output of that size, and the level blurred is kept at (1/2^level)
+  static void blurLevels(const Vector2D &size, int &down, int &stored);
+  static void destroy();
+};
+
+class BackgroundCache {
+public:
+  // Cached background for the monitor's active workspace, dropped textures if anything changed
+  SP<Background> get(PHLMONITOR monitor);
+  void invalidate(PHLMONITOR monitor);
+  void invalidate(PHLWINDOW window);
+  // Called for every frame rendered while the switcher is hidden
+  void onFrameDamage(PHLMONITOR monitor, const CRegion &damage);
+  // Ignore the next frame's damage, used for our own cleanup frame on deactivate
+  void settle(MONITORID id);
+  void clear();
+
+  static int blurSettingsKey();
+
+private:
+  std::map<MONITORID, SP<Background>> entries;
+  std::set<MONITORID> settling;
+};
+
+} // namespace alttab
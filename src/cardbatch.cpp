@@ -0,0 +1,143 @@
+#include "cardbatch.hpp"
+#include "defines.hpp"
+#include "logger.hpp"
+#include <hyprutils/math/Vector2D.hpp>
+#include <src/helpers/Color.hpp>
+#define protected public
+#include <src/render/OpenGL.hpp>
+#undef protected
+
+using namespace alttab;
+
+void CardBatch::clear() {
+  cards.clear();
+  surfaces.clear();
+}
+
+bool CardBatch::empty() const {
+  return cards.empty();
+}
+
+CardRecord &CardBatch::add() {
+  auto &card = cards.emplace_back();
+  card.firstSurface = surfaces.size();
+  return card;
+}
+
+void CardBatch::addSurface(CardRecord &card, const SP<CTexture> &tex, const CBox &box) {
+  surfaces.push_back({tex, box});
+  card.surfaceCount++;
+}
+
+void CardBatch::refreshSnapshots() {
+  const auto &rd = g_pHyprOpenGL->m_renderData;
+  if (!rd.pMonitor || !rd.currentFB)
+    return;
+
+  // The pass renders into the current framebuffer at the output's pixel size
+  const GLTarget target = {.fb = rd.currentFB->getFBID(), .viewport = rd.pMonitor->m_pixelSize};
+  for (auto &card : cards) {
+    auto *snap = card.snapshot;
+    if (!snap || !snap->needsRefresh(card.content.size()))
+      continue;
+    snap->refresh(card.content.size(), {surfaces.data() + card.firstSurface, card.surfaceCount}, card.content.pos(), target);
+  }
+}
+
+CardBatchPassElement::CardBatchPassElement(const CardBatch *batch) : batch(batch) {
+  ;
+}
+
+// Records were built from this frame's damage already, each card draws only into its own clip
+void CardBatchPassElement::draw(const CRegion &damage) {
+  LOG_SCOPE(Log::DRAW)
+  if (!batch)
+    return;
+
+  auto *shader = CardShader::get();
+
+  for (const auto &card : batch->cards) {
+    const auto &l = card.layout;
+    const auto &clip = card.clip;
+
+    if (shader) {
+      // Whole card in one quad. Previews the shader can't sample are drawn over the letterbox.
+      const auto pv = preview(card);
+      shader->draw(card, pv, clip);
+      if (!pv.tex)
+        drawSurfaces(card, clip);
+    } else {
+      g_pHyprOpenGL->renderRect(l.title, CHyprColor(0, 0, 0, 0.8f * card.alpha), {.damage = &clip});
+      g_pHyprOpenGL->renderRect(l.preview, CHyprColor(0, 0, 0, card.alpha), {.damage = &clip});
+
+      if (card.border) {
+        // Borders clip against the render data damage rather than taking one
+        auto &rd = g_pHyprOpenGL->m_renderData;
+        const CRegion frameDamage = rd.damage;
+        rd.damage = clip;
+        g_pHyprOpenGL->renderBorder(l.outer, *card.border,
+                                    {.round = (int)Config::borderRounding,
+                                     .roundingPower = (float)Config::borderRoundingPower,
+                                     .borderSize = (int)Config::borderSize,
+                                     .a = card.alpha});
+        rd.damage = frameDamage;
+      }
+      drawSurfaces(card, clip);
+    }
+
+    if (card.title)
+      renderTitle(card.titleTex, *card.title, card.titlePos, card.alpha, clip);
+    else if (card.titleTex)
+      g_pHyprOpenGL->renderTexture(card.titleTex, card.titleBox, {.damage = &clip, .a = card.alpha});
+
+#ifndef NDEBUG
+    g_pHyprOpenGL->renderRect(l.outer, CHyprColor(0.0, 0.0, 1.0, 0.1), {.damage = &clip});
+#endif
+  }
+}
+
+// Snapshot when possible, the client buffer itself when it's a single plain texture
+CardPreview CardBatchPassElement::preview(const CardRecord &card) {
+  const std::span<const CardSurface> surfaces{batch->surfaces.data() + card.firstSurface, card.surfaceCount};
+
+  // Refreshed by CardBatch::refreshSnapshots() before the pass
+  if (auto *snap = card.snapshot; snap && snap->ready())
+    return {.tex = snap->texture(), .uvScale = snap->uvScale(), .mipmapped = true};
+
+  if (surfaces.size() == 1 && CardShader::canSample(surfaces[0].tex))
+    return {.tex = surfaces[0].tex};
+  return {};
+}
+
+void CardBatchPassElement::drawSurfaces(const CardRecord &card, const CRegion &damage) {
+  for (uint32_t i = 0; i < card.surfaceCount; ++i) {
+    const auto &surface = batch->surfaces[card.firstSurface + i];
+    g_pHyprOpenGL->renderTexture(surface.tex, surface.box, {.damage = &damage, .a = card.alpha});
+  }
+  if (card.dim > 0.0f)
+    g_pHyprOpenGL->renderRect(card.content, CHyprColor(0, 0, 0, card.dim * card.alpha), {.damage = &damage});
+}
+
+bool CardBatchPassElement::needsLiveBlur() {
+  return false;
+}
+
+bool CardBatchPassElement::needsPrecomputeBlur() {
+  return false;
+}
+
+std::optional<CBox> CardBatchPassElement::boundingBox() {
+  if (!batch || batch->cards.empty() || !g_pHyprOpenGL->m_renderData.pMonitor)
+    return std::nullopt;
+
+  double x1 = 1e9, y1 = 1e9, x2 = -1e9, y2 = -1e9;
+  for (const auto &card : batch->cards) {
+    const auto &box = card.layout.outer;
+    x1 = std::min(x1, box.x);
+    y1 = std::min(y1, box.y);
+    x2 = std::max(x2, box.x + box.width);
+    y2 = std::max(y2, box.y + box.height);
+  }
+  // Pass boxes are logical, records are in pixels
+  return CBox{x1, y1, x2 - x1, y2 - y1}.scale(1.0f / g_pHyprOpenGL->m_renderData.pMonitor->m_scale).round();
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "container.hpp"
+#include "cardshader.hpp"
+#include "glyphs.hpp"
+#include "snapshot.hpp"
+#include <src/render/pass/PassElement.hpp>
+#include <vector>
+
+namespace alttab {
+
+struct CardSurface {
+  SP<CTexture> tex;
+  CBox box;
+};
+
+// Everything needed to draw one card, boxes are in monitor pixels
+struct CardRecord {
+  CardLayout layout;
+  // Window aspect fitted into layout.preview
+  CBox content;
+  // Damaged and unoccluded part of the card, nothing outside of it is touched
+  CRegion clip;
+  const CGradientValueData *border = nullptr;
+  float alpha = 1.0f;
+  float dim = 0.0f;
+  SP<CTexture> titleTex;
+  const TitleLayout *title = nullptr;
+  Vector2D titlePos;
+  // Fallback titles are a whole texture, drawn at titleBox when title is null
+  CBox titleBox;
+  // Card-sized copy of the surfaces, refreshed during the pass when outdated
+  CardSnapshot *snapshot = nullptr;
+  // Range into CardBatch::surfaces
+  uint32_t firstSurface = 0;
+  uint32_t surfaceCount = 0;
+};
+
+// Per-frame arena for card draw records. clear() keeps the capacity, so after the first
+// few frames filling it doesn't allocate no matter how many cards there are.
+class CardBatch {
+public:
+  void clear();
+  bool empty() const;
+  CardRecord &add();
+  void addSurface(CardRecord &card, const SP<CTexture> &tex, const CBox &box);
+  // Re-renders outdated snapshots. Goes before the pass, each refresh rebinds the framebuffer.
+  void refreshSnapshots();
+
+  std::vector<CardRecord> cards;
+  std::vector<CardSurface> surfaces;
+};
+
+// Draws every card of a frame as one pass element, back to front in submission order
+class CardBatchPassElement : public IPassElement {
+public:
+  CardBatchPassElement(const CardBatch *batch);
+  virtual ~CardBatchPassElement() = default;
+
+  virtual void draw(const CRegion &damage);
+  virtual bool needsLiveBlur();
+  virtual bool needsPrecomputeBlur();
+  virtual std::optional<CBox> boundingBox();
+
+  virtual const char *passName() {
+    return "CardBatchPassElement";
+  }
+
+private:
+  void drawSurfaces(const CardRecord &card, const CRegion &damage);
+  CardPreview preview(const CardRecord &card);
+  const CardBatch *batch = nullptr;
+};
+
+} // namespace alttab
@@ -0,0 +1,296 @@
+#include "cardshader.hpp"
+#include "cardbatch.hpp"
+#include "logger.hpp"
+#include <hyprutils/math/Vector2D.hpp>
+#include <src/helpers/math/Math.hpp>
+
+#define private public
+#define protected public
+#include <src/render/OpenGL.hpp>
+#undef protected
+#undef private
+
+using namespace alttab;
+
+// Hyprland gradients take up to 10 colors, borderColors in FRAG has the same size
+constexpr int MAX_BORDER_STOPS = 10;
+
+static const char *VERT = R"#(#version 300 es
+uniform mat3 proj;
+in vec2 pos;
+out vec2 v_pos;
+
+void main() {
+  gl_Position = vec4(proj * vec3(pos, 1.0), 1.0);
+  v_pos = pos;
+}
+)#";
+
+// Everything is in card pixels, origin top-left. Output is premultiplied.
+static const char *FRAG = R"#(#version 300 es
+precision highp float;
+in vec2 v_pos;
+
+uniform vec2 size;
+uniform float radius;
+uniform float roundingPower;
+uniform float borderSize;
+uniform vec4 borderColors[10];
+uniform int borderCount;
+uniform float borderAngle;
+uniform float titleHeight;
+uniform vec4 content;
+uniform vec2 uvScale;
+uniform sampler2D tex;
+uniform int hasTex;
+uniform int opaqueTex;
+uniform float alpha;
+uniform float dim;
+
+out vec4 fragColor;
+
+float roundedDist(vec2 p, vec2 halfSize, float r) {
+  vec2 q = abs(p) - halfSize + r;
+  vec2 c = max(q, 0.0);
+  float corner = c == vec2(0.0) ? 0.0 : pow(pow(c.x, roundingPower) + pow(c.y, roundingPower), 1.0 / roundingPower);
+  return corner + min(max(q.x, q.y), 0.0) - r;
+}
+
+vec4 borderColor(vec2 p) {
+  vec2 dir = vec2(cos(borderAngle), sin(borderAngle));
+  float t = clamp(dot(p / size - 0.5, dir) + 0.5, 0.0, 1.0) * float(borderCount - 1);
+  int i = int(floor(t));
+  vec4 c = mix(borderColors[i], borderColors[min(i + 1, borderCount - 1)], fract(t));
+  return vec4(c.rgb * c.a, c.a);
+}
+
+void main() {
+  vec2 p = v_pos * size;
+  vec2 center = size * 0.5;
+
+  float outer = roundedDist(p - center, center, radius);
+  float coverage = clamp(0.5 - outer, 0.0, 1.0);
+  if (coverage <= 0.0)
+    discard;
+
+  vec4 inner;
+  if (p.y < borderSize + titleHeight) {
+    inner = vec4(0.0, 0.0, 0.0, 0.8);
+  } else {
+    inner = vec4(0.0, 0.0, 0.0, 1.0);
+    vec2 uv = (p - content.xy) / content.zw;
+    if (hasTex == 1 && all(greaterThanEqual(uv, vec2(0.0))) && all(lessThanEqual(uv, vec2(1.0)))) {
+      vec4 s = texture(tex, uv * uvScale);
+      if (opaqueTex == 1)
+        s.a = 1.0;
+      // Over the black preview background
+      inner = vec4(s.rgb, 1.0);
+    }
+    inner.rgb *= 1.0 - dim;
+  }
+
+  vec4 color = inner;
+  if (borderSize > 0.0) {
+    float innerDist = roundedDist(p - center, center - borderSize, max(radius - borderSize, 0.0));
+    color = mix(inner, borderColor(p), clamp(innerDist + 0.5, 0.0, 1.0));
+  }
+
+  fragColor = color * coverage * alpha;
+}
+)#";
+
+static GLuint compileStage(GLenum type, const char *src) {
+  GLuint shader = glCreateShader(type);
+  glShaderSource(shader, 1, &src, nullptr);
+  glCompileShader(shader);
+
+  GLint ok = GL_FALSE;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+  if (ok != GL_TRUE) {
+    char log[1024] = {};
+    glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+    LOG(Log::DRAW, "shader compile failed: {}", log);
+    glDeleteShader(shader);
+    return 0;
+  }
+  return shader;
+}
+
+CardShader::~CardShader() {
+  if (vbo)
+    glDeleteBuffers(1, &vbo);
+  if (vao)
+    glDeleteVertexArrays(1, &vao);
+  if (program)
+    glDeleteProgram(program);
+}
+
+CardShader *CardShader::get() {
+  if (instance)
+    return instance.get();
+  if (failed)
+    return nullptr;
+
+  auto shader = makeUnique<CardShader>();
+  if (!shader->compile()) {
+    // Don't retry every frame, the batch falls back to the stock elements
+    failed = true;
+    return nullptr;
+  }
+  instance = std::move(shader);
+  return instance.get();
+}
+
+void CardShader::destroy() {
+  instance.reset();
+  failed = false;
+}
+
+GLuint alttab::compileProgram(const char *vertSrc, const char *fragSrc) {
+  GLuint vert = compileStage(GL_VERTEX_SHADER, vertSrc);
+  GLuint frag = compileStage(GL_FRAGMENT_SHADER, fragSrc);
+  if (!vert || !frag) {
+    if (vert)
+      glDeleteShader(vert);
+    if (frag)
+      glDeleteShader(frag);
+    return 0;
+  }
+
+  GLuint program = glCreateProgram();
+  glAttachShader(program, vert);
+  glAttachShader(program, frag);
+  glBindAttribLocation(program, 0, "pos");
+  glLinkProgram(program);
+  glDeleteShader(vert);
+  glDeleteShader(frag);
+
+  GLint ok = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &ok);
+  if (ok != GL_TRUE) {
+    char log[1024] = {};
+    glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+    LOG(Log::DRAW, "shader link failed: {}", log);
+    glDeleteProgram(program);
+    return 0;
+  }
+  return program;
+}
+
+GLuint alttab::createUnitQuad(GLuint &vbo) {
+  // Unit quad as a strip, same winding as the compositor's own quads
+  static const GLfloat verts[] = {1, 0, 0, 0, 1, 1, 0, 1};
+  GLuint vao = 0;
+  glGenVertexArrays(1, &vao);
+  glGenBuffers(1, &vbo);
+  glBindVertexArray(vao);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  return vao;
+}
+
+bool CardShader::compile() {
+  program = compileProgram(VERT, FRAG);
+  if (!program)
+    return false;
+
+  loc.proj = glGetUniformLocation(program, "proj");
+  loc.size = glGetUniformLocation(program, "size");
+  loc.radius = glGetUniformLocation(program, "radius");
+  loc.roundingPower = glGetUniformLocation(program, "roundingPower");
+  loc.borderSize = glGetUniformLocation(program, "borderSize");
+  loc.borderColors = glGetUniformLocation(program, "borderColors");
+  loc.borderCount = glGetUniformLocation(program, "borderCount");
+  loc.borderAngle = glGetUniformLocation(program, "borderAngle");
+  loc.titleHeight = glGetUniformLocation(program, "titleHeight");
+  loc.content = glGetUniformLocation(program, "content");
+  loc.uvScale = glGetUniformLocation(program, "uvScale");
+  loc.tex = glGetUniformLocation(program, "tex");
+  loc.hasTex = glGetUniformLocation(program, "hasTex");
+  loc.opaqueTex = glGetUniformLocation(program, "opaqueTex");
+  loc.alpha = glGetUniformLocation(program, "alpha");
+  loc.dim = glGetUniformLocation(program, "dim");
+
+  vao = createUnitQuad(vbo);
+  return true;
+}
+
+bool CardShader::canSample(const SP<CTexture> &tex) {
+  return tex && (tex->m_type == TEXTURE_RGBA || tex->m_type == TEXTURE_RGBX);
+}
+
+void CardShader::draw(const CardRecord &card, const CardPreview &preview, const CRegion &damage) {
+  auto &rd = g_pHyprOpenGL->m_renderData;
+  CBox box = card.layout.outer;
+  if (box.w <= 0 || box.h <= 0 || !rd.pMonitor)
+    return;
+
+  CRegion clip = damage.copy().intersect(box);
+  if (clip.empty())
+    return;
+
+  rd.renderModif.applyToBox(box);
+  const auto TRANSFORM = Math::wlTransformToHyprutils(
+      Math::invertTransform(!g_pHyprOpenGL->m_monitorTransformEnabled ? WL_OUTPUT_TRANSFORM_NORMAL : rd.pMonitor->m_transform));
+  Mat3x3 matrix = rd.monitorProjection.projectBox(box, TRANSFORM, box.rot);
+  Mat3x3 glMatrix = rd.projection.copy().multiply(matrix);
+
+  g_pHyprOpenGL->blend(true);
+  g_pHyprOpenGL->useProgram(program);
+
+  glUniformMatrix3fv(loc.proj, 1, GL_TRUE, glMatrix.getMatrix().data());
+  glUniform2f(loc.size, card.layout.outer.w, card.layout.outer.h);
+  glUniform1f(loc.radius, std::min<float>(Config::borderRounding, std::min(card.layout.outer.w, card.layout.outer.h) * 0.5f));
+  glUniform1f(loc.roundingPower, Config::borderRoundingPower);
+  glUniform1f(loc.borderSize, card.border ? Config::borderSize : 0);
+  glUniform1f(loc.titleHeight, card.layout.title.h);
+  glUniform1f(loc.alpha, card.alpha);
+  glUniform1f(loc.dim, card.dim);
+
+  if (card.border && !card.border->m_colors.empty()) {
+    GLfloat colors[MAX_BORDER_STOPS * 4] = {};
+    const int count = std::min<int>(card.border->m_colors.size(), MAX_BORDER_STOPS);
+    for (int i = 0; i < count; ++i) {
+      const auto &c = card.border->m_colors[i];
+      colors[i * 4 + 0] = c.r;
+      colors[i * 4 + 1] = c.g;
+      colors[i * 4 + 2] = c.b;
+      colors[i * 4 + 3] = c.a;
+    }
+    glUniform4fv(loc.borderColors, MAX_BORDER_STOPS, colors);
+    glUniform1i(loc.borderCount, count);
+    glUniform1f(loc.borderAngle, card.border->m_angle);
+  } else
+    glUniform1i(loc.borderCount, 1);
+
+  // Letterboxed preview rect relative to the card
+  const auto &content = card.content;
+  glUniform4f(loc.content, content.x - card.layout.outer.x, content.y - card.layout.outer.y, content.w, content.h);
+
+  const auto &tex = preview.tex;
+  if (tex) {
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(tex->m_target, tex->m_texID);
+    glTexParameteri(tex->m_target, GL_TEXTURE_MIN_FILTER, preview.mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(tex->m_target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glUniform1i(loc.tex, 0);
+    glUniform1i(loc.opaqueTex, tex->m_type == TEXTURE_RGBX);
+    glUniform2f(loc.uvScale, preview.uvScale.x, preview.uvScale.y);
+  }
+  glUniform1i(loc.hasTex, tex ? 1 : 0);
+
+  glBindVertexArray(vao);
+  clip.forEachRect([](const auto &RECT) {
+    g_pHyprOpenGL->scissor(&RECT);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  });
+  g_pHyprOpenGL->scissor(nullptr);
+  glBindVertexArray(0);
+
+  if (tex)
+    glBindTexture(tex->m_target, 0);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "defines.hpp"
+#include <GLES3/gl32.h>
+#include <src/render/Texture.hpp>
+
+namespace alttab {
+
+struct CardRecord;
+
+// Shared by the card and snapshot programs. Attribute 0 is "pos".
+GLuint compileProgram(const char *vert, const char *frag);
+GLuint createUnitQuad(GLuint &vbo);
+
+struct CardPreview {
+  SP<CTexture> tex;
+  // Part of tex that holds the preview, snapshots can be smaller than their framebuffer
+  Vector2D uvScale = {1, 1};
+  bool mipmapped = false;
+};
+
+// Draws border, title bar, preview background, letterboxed preview and dim of a card
+// in one quad. Title glyphs still go through renderTitle() on top.
+class CardShader {
+public:
+  ~CardShader();
+
+  // Compiles lazily on first use, nullptr if the driver refused the shader
+  static CardShader *get();
+  static void destroy();
+
+  // External (dmabuf) textures need a different sampler, those previews are drawn by the caller
+  static bool canSample(const SP<CTexture> &tex);
+  // preview.tex may be null, then only the letterbox background is drawn
+  void draw(const CardRecord &card, const CardPreview &preview, const CRegion &damage);
+
+private:
+  bool compile();
+
+  GLuint program = 0;
+  GLuint vao = 0;
+  GLuint vbo = 0;
+  struct {
+    GLint proj = -1;
+    GLint size = -1;
+    GLint radius = -1;
+    GLint roundingPower = -1;
+    GLint borderSize = -1;
+    GLint borderColors = -1;
+    GLint borderCount = -1;
+    GLint borderAngle = -1;
+    GLint titleHeight = -1;
+    GLint content = -1;
+    GLint uvScale = -1;
+    GLint tex = -1;
+    GLint hasTex = -1;
+    GLint opaqueTex = -1;
+    GLint alpha = -1;
+    GLint dim = -1;
+  } loc;
+
+  static inline UP<CardShader> instance;
+  static inline bool failed = false;
+};
+
+} // namespace alttab
@@ -1,22 +1,31 @@
 #include "container.hpp"
+#include "cardbatch.hpp"
 #include "defines.hpp"
 #include "helpers.hpp"
 #include "logger.hpp"
+#include "manager.hpp"
 #include <hyprutils/math/Vector2D.hpp>
 #include <src/desktop/state/FocusState.hpp>
 #include <src/desktop/view/Window.hpp>
 #include <src/helpers/Color.hpp>
 #include <src/protocols/PresentationTime.hpp>
-#include <src/render/pass/BorderPassElement.hpp>
-#include <src/render/pass/RectPassElement.hpp>
-#include <src/render/pass/TexPassElement.hpp>
 #define protected public
 #include <src/render/OpenGL.hpp>
 #include <src/render/Renderer.hpp>
 #undef protected
 
 WindowCard::WindowCard(PHLWINDOW window) : window(window) {
-  ;
+  if (window && window->wlSurface() && window->wlSurface()->resource())
+    commitListener = window->wlSurface()->resource()->m_events.commit.listen([this] { onCommit(); });
+}
+
+void WindowCard::onCommit() {
+  if (!manager)
+    return;
+  snapshot.invalidate();
+  manager->invalidateBackground(window);
+  if (Config::livePreview && previewVisible)
+    manager->damagePreview(this);
 }
 
 void WindowCard::setPosition(const CBox &position) {
@@ -27,90 +36,59 @@ CBox WindowCard::getPosition() const {
   return position;
 }
 
-void WindowCard::draw(const CRegion& damage) {
+void WindowCard::draw(alttab::CardBatch &batch, float alpha, const CRegion &clip) {
   LOG_SCOPE(Log::DRAW);
 
   if (!window || !window->wlSurface() || !window->wlSurface()->resource())
     return;
 
   const auto MONITOR = Desktop::focusState()->monitor();
+  const auto SURFACE = window->wlSurface()->resource();
 
   const float scale = MONITOR->m_scale;
-  const float alpha = 1.0f;
-
-  auto layout = buildLayout(scale);
-
-  updateTitleTexture(scale);
-
-  // Title bar background — deferred
-  {
-    CRectPassElement::SRectData rect;
-    rect.box = layout.title;
-    rect.color = {0, 0, 0, 0.8f * alpha};
-    g_pHyprRenderer->m_renderPass.add(makeUnique<CRectPassElement>(rect));
-  }
 
-  // Preview background — deferred
-  {
-    CRectPassElement::SRectData rect;
-    rect.box = layout.preview;
-    rect.color = {0, 0, 0, alpha};
-    g_pHyprRenderer->m_renderPass.add(makeUnique<CRectPassElement>(rect));
+  updateTitleLayout(scale);
+
+  // Just a record, the whole frame's cards are drawn by one CardBatchPassElement
+  auto &card = batch.add();
+  card.layout = buildLayout(scale);
+  card.border = isActive ? Config::activeBorderColor : Config::inactiveBorderColor;
+  card.clip = clip;
+  card.snapshot = &snapshot;
+  card.alpha = alpha;
+  card.dim = (!isActive && Config::dimEnabled) ? Config::dimAmount : 0.0f;
+
+  // Letterbox the window into the preview area instead of stretching it
+  const Vector2D surfaceSize = SURFACE->m_current.size;
+  const auto &preview = card.layout.preview;
+  float fit = 1.0f;
+  card.content = preview;
+  if (surfaceSize.x > 0 && surfaceSize.y > 0) {
+    fit = std::min(preview.width / surfaceSize.x, preview.height / surfaceSize.y);
+    const Vector2D size = surfaceSize * fit;
+    card.content = CBox{preview.pos() + (preview.size() - size) * 0.5f, size}.round();
   }
 
-  // Border — deferred
-  {
-    CBorderPassElement::SBorderData border;
-    border.box = layout.outer;
-    border.grad1 = (isActive) ? *Config::activeBorderColor : *Config::inactiveBorderColor;
-    border.borderSize = Config::borderSize;
-    border.round = Config::borderRounding;
-    border.roundingPower = Config::borderRoundingPower;
-    g_pHyprRenderer->m_renderPass.add(makeUnique<CBorderPassElement>(border));
-  }
-
-  // Window surface texture — deferred
-  window->wlSurface()->resource()->breadthfirst(
+  SURFACE->breadthfirst(
       [&](SP<CWLSurfaceResource> s, const Vector2D &offset, void *) {
         if (!s->m_current.texture)
           return;
-
-        CTexPassElement::SRenderData tex;
-        tex.tex = s->m_current.texture;
-        tex.box = {
-            layout.preview.pos() + (offset * scale),
-            layout.preview.size()};
-        tex.a = alpha;
-
-        g_pHyprRenderer->m_renderPass.add(makeUnique<CTexPassElement>(tex));
+        const Vector2D size = s == SURFACE ? card.content.size() : s->m_current.size * fit;
+        batch.addSurface(card, s->m_current.texture, {card.content.pos() + offset * fit, size});
       },
       nullptr);
 
-  // Title text — deferred
   if (titleTexture) {
-
-    Vector2D size = titleTexture->m_size * scale;
-    Vector2D pos = layout.title.pos() + (layout.title.size() - size) * 0.5f;
-
-    CTexPassElement::SRenderData tex;
-    tex.tex = titleTexture;
-    tex.box = {pos, size};
-    tex.a = alpha;
-
-    g_pHyprRenderer->m_renderPass.add(makeUnique<CTexPassElement>(tex));
-  }
-
-#ifndef NDEBUG
-  // Debug overlay — deferred
-  {
-    CRectPassElement::SRectData rect;
-    rect.box = layout.outer;
-    rect.color = {0.0, 0.0, 1.0, 0.1};
-    g_pHyprRenderer->m_renderPass.add(makeUnique<CRectPassElement>(rect));
+    const Vector2D size = titleTexture->m_size * scale;
+    const Vector2D pos = card.layout.title.pos() + (card.layout.title.size() - size) * 0.5f;
+    card.titleTex = titleTexture;
+    card.titleBox = {std::round(pos.x), std::round(pos.y), size.x, size.y};
+  } else if (!titleLayout.quads.empty()) {
+    const Vector2D pos = card.layout.title.pos() + (card.layout.title.size() - titleLayout.size) * 0.5f;
+    card.titleTex = alttab::GlyphAtlas::get(Config::fontSize, scale).texture();
+    card.title = &titleLayout;
+    card.titlePos = {std::round(pos.x), std::round(pos.y)}; // keep glyphs on the pixel grid
   }
-#endif
-
-  // NO per-card flush — the single flush happens in Manager::onRender()
 }
 
 void WindowCard::present() {
@@ -120,7 +98,23 @@ void WindowCard::present() {
       nullptr);
 }
 
-CardLayout WindowCard::buildLayout(float scale) {
+bool WindowCard::presentIfDue(const Timestamp &now) {
+  if (presentInterval < 0.0f)
+    return false;
+  if (presentInterval > 0.0f && FloatTime(now - lastPresent).count() < presentInterval)
+    return false;
+  present();
+  lastPresent = now;
+  return true;
+}
+
+std::optional<Timestamp> WindowCard::nextPresent() const {
+  if (presentInterval <= 0.0f)
+    return std::nullopt;
+  return lastPresent + std::chrono::duration_cast<Timestamp::duration>(FloatTime(presentInterval));
+}
+
+CardLayout WindowCard::buildLayout(float scale) const {
   CardLayout l;
   l.outer = position;
   l.outer.round();
@@ -146,22 +140,36 @@ CardLayout WindowCard::buildLayout(float scale) {
   return l;
 }
 
-void WindowCard::updateTitleTexture(float scale) {
+// Used by resident mode to keep the title layout current while the switcher is hidden
+void WindowCard::refreshTitle() {
+  const auto MONITOR = Desktop::focusState()->monitor();
+  updateTitleLayout(MONITOR ? MONITOR->m_scale : 1.0f);
+}
+
+// Only glyphs never seen before hit cairo, everything else is a lookup of cached advances
+void WindowCard::updateTitleLayout(float scale) {
   if (!window)
     return;
 
   float baseWidth = position.width;
   float padding = 10.f;
 
-  if (window->m_title == title && std::abs(lastBaseWidth - baseWidth) < 1.f)
+  auto &atlas = alttab::GlyphAtlas::get(Config::fontSize, scale);
+  const int pixelSize = std::max(1, (int)std::round(Config::fontSize * scale));
+
+  if (window->m_title == title && std::abs(lastBaseWidth - baseWidth) < 1.f && titlePixelSize == pixelSize &&
+      titleLayout.generation == atlas.generation())
     return;
 
   lastBaseWidth = baseWidth;
   title = window->m_title;
-
-  int maxChars = std::max(
-      5.0f,
-      (float)((baseWidth - padding) / (Config::fontSize * 0.55f)));
-  auto display = middleTruncate(title, maxChars);
-  titleTexture = g_pHyprOpenGL->renderText(display, CHyprColor(1, 1, 1, 1), Config::fontSize);
+  titlePixelSize = pixelSize;
+  titleLayout = atlas.layout(title, std::max(0.0f, (baseWidth - padding) * scale));
+
+  // Pango shapes and falls back to other fonts, worth the full texture for these
+  titleTexture.reset();
+  if (titleLayout.fallback) {
+    const int maxChars = std::max(5.0f, (float)((baseWidth - padding) / (Config::fontSize * 0.55f)));
+    titleTexture = g_pHyprOpenGL->renderText(middleTruncate(title, maxChars), CHyprColor(1, 1, 1, 1), Config::fontSize);
+  }
 }
@@ -1,9 +1,16 @@
 #pragma once
 
 #include "defines.hpp"
+#include "glyphs.hpp"
+#include "snapshot.hpp"
+#include <src/helpers/signal/Signal.hpp>
 #include <src/protocols/core/Compositor.hpp>
 #include <src/render/Framebuffer.hpp>
 
+namespace alttab {
+class CardBatch;
+}
+
 struct CardData {
   CBox position;
   float z;
@@ -21,24 +28,37 @@ struct CardLayout {
 class WindowCard {
 public:
   WindowCard(PHLWINDOW window);
-  void draw(const CRegion& damage);
+  void draw(alttab::CardBatch &batch, float alpha, const CRegion &clip);
   void present();
+  // Frame callbacks only as often as presentInterval allows
+  bool presentIfDue(const Timestamp &now);
+  std::optional<Timestamp> nextPresent() const;
   void setPosition(const CBox &position);
   CBox getPosition() const;
-  CardLayout buildLayout(float scale);
+  CardLayout buildLayout(float scale) const;
+  void refreshTitle();
 
   PHLWINDOW window;
-  Timestamp lastSnapshot;
-  bool ready = false;
   float z = 0.0f;
   bool isActive = false;
-  bool firstSnapshot = true;
   CBox lastBox;
+  // Set by Monitor::update, commits of hidden cards don't damage anything
+  bool previewVisible = false;
+  // Seconds between frame callbacks, set by Monitor::update. 0 is every frame, < 0 none.
+  float presentInterval = 0.0f;
+  Timestamp lastPresent;
+  PHLMONITORREF output;
+  alttab::CardSnapshot snapshot;
   float lastBaseWidth = -1.f;
 
 private:
-  void updateTitleTexture(float scale);
+  void updateTitleLayout(float scale);
+  void onCommit();
   CBox position;
   std::string title;
+  alttab::TitleLayout titleLayout;
+  // Only for titles the atlas can't draw
   SP<CTexture> titleTexture;
+  int titlePixelSize = 0;
+  CHyprSignalListener commitListener;
 };
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "defines.hpp"
+#include <vector>
+
+// Collects damage as a few rects. A new rect is folded into an existing one only when the
+// union wastes little area, so cards far apart stay separate instead of damaging everything
+// between them. Past MAX_RECTS the cheapest pair is merged.
+class DamageAccumulator {
+public:
+  static constexpr size_t MAX_RECTS = 8;
+  // Merge when the union adds less than this share of its own area, or less than a small
+  // absolute amount, where an extra scissor costs more than the pixels
+  static constexpr double MAX_WASTE_RATIO = 0.25;
+  static constexpr double MIN_WASTE = 64.0 * 64.0;
+
+  void clear() {
+    boxes.clear();
+  }
+
+  bool empty() const {
+    return boxes.empty();
+  }
+
+  void add(const CBox &box) {
+    if (box.w <= 0 || box.h <= 0)
+      return;
+
+    CBox current = box;
+    // Merging grows the rect, which can make it worth merging with another one
+    while (true) {
+      size_t best = boxes.size();
+      double bestWaste = 0.0;
+      for (size_t i = 0; i < boxes.size(); ++i) {
+        const double w = waste(boxes[i], current);
+        if (w <= threshold(boxes[i], current) && (best == boxes.size() || w < bestWaste)) {
+          best = i;
+          bestWaste = w;
+        }
+      }
+      if (best == boxes.size())
+        break;
+      current = unite(boxes[best], current);
+      boxes[best] = boxes.back();
+      boxes.pop_back();
+    }
+    boxes.push_back(current);
+
+    if (boxes.size() > MAX_RECTS)
+      mergeCheapest();
+  }
+
+  void addTo(CRegion &region) const {
+    for (const auto &box : boxes)
+      region.add(box);
+  }
+
+  const std::vector<CBox> &rects() const {
+    return boxes;
+  }
+
+private:
+  static CBox unite(const CBox &a, const CBox &b) {
+    const double x1 = std::min(a.x, b.x), y1 = std::min(a.y, b.y);
+    const double x2 = std::max(a.x + a.w, b.x + b.w), y2 = std::max(a.y + a.h, b.y + b.h);
+    return {x1, y1, x2 - x1, y2 - y1};
+  }
+
+  static double overlap(const CBox &a, const CBox &b) {
+    const double w = std::min(a.x + a.w, b.x + b.w) - std::max(a.x, b.x);
+    const double h = std::min(a.y + a.h, b.y + b.h) - std::max(a.y, b.y);
+    return (w > 0 && h > 0) ? w * h : 0.0;
+  }
+
+  // Area the union covers that neither rect did
+  static double waste(const CBox &a, const CBox &b) {
+    const CBox u = unite(a, b);
+    return u.w * u.h - (a.w * a.h + b.w * b.h - overlap(a, b));
+  }
+
+  static double threshold(const CBox &a, const CBox &b) {
+    const CBox u = unite(a, b);
+    return std::max(MIN_WASTE, u.w * u.h * MAX_WASTE_RATIO);
+  }
+
+  void mergeCheapest() {
+    size_t bi = 0, bj = 1;
+    double bestWaste = -1.0;
+    for (size_t i = 0; i < boxes.size(); ++i)
+      for (size_t j = i + 1; j < boxes.size(); ++j) {
+        const double w = waste(boxes[i], boxes[j]);
+        if (bestWaste < 0.0 || w < bestWaste) {
+          bestWaste = w;
+          bi = i;
+          bj = j;
+        }
+      }
+    boxes[bi] = unite(boxes[bi], boxes[bj]);
+    boxes[bj] = boxes.back();
+    boxes.pop_back();
+  }
+
+  std::vector<CBox> boxes;
+};
+
+// Card damage of the last few frames of one output. A buffer that is `age` frames old is
+// missing everything drawn since, so each frame submits the union of the last
+// (swapchain length - 1) frames on top of its own damage.
+class DamageRing {
+public:
+  void setDepth(size_t depth) {
+    depth = std::max<size_t>(depth, 1);
+    if (frames.size() == depth)
+      return;
+    frames.assign(depth, {});
+    head = 0;
+  }
+
+  // This frame's damage goes here until push()
+  CRegion pending;
+
+  void addTo(CRegion &region) const {
+    region.add(pending);
+    for (const auto &frame : frames)
+      region.add(frame);
+  }
+
+  void push() {
+    if (frames.empty())
+      setDepth(1);
+    frames[head] = pending;
+    head = (head + 1) % frames.size();
+    pending.clear();
+  }
+
+  void clear() {
+    for (auto &frame : frames)
+      frame.clear();
+    pending.clear();
+  }
+
+private:
+  std::vector<CRegion> frames;
+  size_t head = 0;
+};
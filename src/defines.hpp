@@ -30,10 +30,13 @@ enum class Direction : uint8_t {
   X(INT, dimEnabled, "dim", 1)                                     \
   X(FLOAT, dimAmount, "dim_amount", 0.3f)                          \
   X(INT, blurBG, "blur", 1)                                        \
+  X(INT, blurQuality, "blur_quality", 1)                           \
   X(FLOAT, unfocusedAlpha, "unfocused_alpha", 0.6f)                \
   X(INT, powersave, "powersave", 1)                                \
   X(INT, livePreview, "live_preview", 1)                           \
   X(FLOAT, previewCutoff, "preview_cutoff", 0.25f)                 \
+  X(FLOAT, previewRateMid, "preview_rate_mid", 15.0f)              \
+  X(FLOAT, previewRateBack, "preview_rate_back", 2.0f)             \
   X(FLOAT, rotationSpeed, "animation_speed", 1.0f)                 \
   X(FLOAT, windowSize, "window_size", 0.3f)                        \
   X(FLOAT, windowSizeActive, "window_size_active", 1.2f)           \
@@ -45,8 +48,12 @@ enum class Direction : uint8_t {
   X(FLOAT, monitorSpacing, "monitor_spacing", 0.3f)                \
   X(FLOAT, monitorAnimationSpeed, "monitor_animation_speed", 0.4f) \
   X(FLOAT, monitorFade, "monitor_fade", 0.4f)                      \
+  X(STRING, rotationCurve, "rotation_curve", "")                  \
+  X(STRING, monitorCurve, "monitor_curve", "")                    \
+  X(STRING, fadeCurve, "fade_curve", "")                          \
   X(INT, grace, "grace", 100)                                      \
   X(INT, includeSpecial, "include_special", 1)                     \
+  X(INT, resident, "resident", 0)                                  \
   X(STRING, style, "style", "carousel")
 
 #define CONFIG_VARS_OPTIONAL_FLOAT              \
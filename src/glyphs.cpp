@@ -0,0 +1,464 @@
+#include "glyphs.hpp"
+#include "logger.hpp"
+#include <drm_fourcc.h>
+#include <hyprutils/math/Vector2D.hpp>
+#include <src/config/ConfigValue.hpp>
+#include <src/helpers/math/Math.hpp>
+#define private public
+#define protected public
+#include <src/render/OpenGL.hpp>
+#undef protected
+#undef private
+
+using namespace alttab;
+
+static uint64_t nextGeneration = 0;
+
+// pos is relative to the text line, 0..1 across its size. Atlas texels are premultiplied.
+static const char *TITLE_VERT = R"#(#version 300 es
+uniform mat3 proj;
+layout(location = 0) in vec2 pos;
+layout(location = 1) in vec2 uv;
+out vec2 v_uv;
+
+void main() {
+  gl_Position = vec4(proj * vec3(pos, 1.0), 1.0);
+  v_uv = uv;
+}
+)#";
+
+static const char *TITLE_FRAG = R"#(#version 300 es
+precision mediump float;
+uniform sampler2D tex;
+uniform float alpha;
+in vec2 v_uv;
+out vec4 fragColor;
+
+void main() {
+  fragColor = texture(tex, v_uv) * alpha;
+}
+)#";
+
+// Splits UTF-8 into (codepoint, bytes) pairs. Invalid bytes decode as U+FFFD.
+static std::vector<std::pair<uint32_t, std::string_view>> decodeUtf8(std::string_view str) {
+  std::vector<std::pair<uint32_t, std::string_view>> out;
+  out.reserve(str.size());
+  size_t i = 0;
+  while (i < str.size()) {
+    const auto c = (unsigned char)str[i];
+    size_t len = 1;
+    uint32_t cp = c;
+    if (c >= 0xF0 && c < 0xF8) {
+      len = 4;
+      cp = c & 0x07;
+    } else if (c >= 0xE0) {
+      len = 3;
+      cp = c & 0x0F;
+    } else if (c >= 0xC0) {
+      len = 2;
+      cp = c & 0x1F;
+    } else if (c >= 0x80) {
+      out.emplace_back(0xFFFD, str.substr(i, 1));
+      i++;
+      continue;
+    }
+
+    if (i + len > str.size()) {
+      out.emplace_back(0xFFFD, str.substr(i));
+      break;
+    }
+    for (size_t k = 1; k < len; ++k)
+      cp = (cp << 6) | ((unsigned char)str[i + k] & 0x3F);
+
+    out.emplace_back(cp, str.substr(i, len));
+    i += len;
+  }
+  return out;
+}
+
+// Scripts and marks that only look right after shaping, which the toy font API doesn't do
+static bool needsShaping(uint32_t cp) {
+  return (cp >= 0x0300 && cp <= 0x036F) ||  // combining diacritics
+         (cp >= 0x0590 && cp <= 0x08FF) ||  // hebrew, arabic, syriac, thaana, nko
+         (cp >= 0x0900 && cp <= 0x109F) ||  // indic, thai, lao, tibetan, myanmar
+         (cp >= 0x1100 && cp <= 0x11FF) ||  // hangul jamo
+         (cp >= 0x1AB0 && cp <= 0x1AFF) || (cp >= 0x1DC0 && cp <= 0x1DFF) || (cp >= 0x20D0 && cp <= 0x20FF) ||
+         (cp >= 0x200C && cp <= 0x200F) ||  // joiners, bidi marks
+         (cp >= 0xFE00 && cp <= 0xFE0F) ||  // variation selectors
+         (cp >= 0xFE20 && cp <= 0xFE2F) || (cp >= 0xFB1D && cp <= 0xFDFF) || (cp >= 0xFE70 && cp <= 0xFEFF) ||
+         cp >= 0x1F000; // emoji and friends, colour fonts and fallback faces
+}
+
+GlyphAtlas::GlyphAtlas(int pixelSize) : pixelSize(pixelSize) {
+  static auto PFONTFAMILY = CConfigValue<std::string>("misc:font_family");
+
+  atlasSize = std::clamp(pixelSize * 32, 256, 2048);
+  surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, atlasSize, atlasSize);
+  cairo = cairo_create(surface);
+
+  auto *face = cairo_toy_font_face_create((*PFONTFAMILY).c_str(), CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+  cairo_matrix_t fontMatrix, ctm;
+  cairo_matrix_init_scale(&fontMatrix, pixelSize, pixelSize);
+  cairo_matrix_init_identity(&ctm);
+  auto *options = cairo_font_options_create();
+  cairo_font_options_set_antialias(options, CAIRO_ANTIALIAS_GRAY);
+  cairo_font_options_set_hint_metrics(options, CAIRO_HINT_METRICS_ON);
+  font = cairo_scaled_font_create(face, &fontMatrix, &ctm, options);
+  cairo_font_options_destroy(options);
+  cairo_font_face_destroy(face);
+
+  cairo_font_extents_t extents;
+  cairo_scaled_font_extents(font, &extents);
+  ascent = extents.ascent;
+  lineHeight = extents.ascent + extents.descent;
+
+  cairo_set_scaled_font(cairo, font);
+  cairo_set_source_rgba(cairo, 1, 1, 1, 1);
+
+  reset();
+}
+
+GlyphAtlas::~GlyphAtlas() {
+  tex.reset();
+  if (font)
+    cairo_scaled_font_destroy(font);
+  if (cairo)
+    cairo_destroy(cairo);
+  if (surface)
+    cairo_surface_destroy(surface);
+}
+
+void GlyphAtlas::reset() {
+  LOG(Log::DRAW, "glyph atlas {}px reset, {} glyphs", pixelSize, glyphs.size());
+  cairo_save(cairo);
+  cairo_set_operator(cairo, CAIRO_OPERATOR_CLEAR);
+  cairo_paint(cairo);
+  cairo_restore(cairo);
+
+  glyphs.clear();
+  penX = penY = 1;
+  rowHeight = 0;
+  dirty = CBox{0, 0, (double)atlasSize, (double)atlasSize};
+  gen = ++nextGeneration;
+}
+
+bool GlyphAtlas::rasterize(Glyph &out, uint32_t codepoint, std::string_view utf8) {
+  cairo_glyph_t *glyphList = nullptr;
+  int count = 0;
+  if (cairo_scaled_font_text_to_glyphs(font, 0, 0, utf8.data(), utf8.size(), &glyphList, &count, nullptr, nullptr, nullptr) != CAIRO_STATUS_SUCCESS || count < 1) {
+    if (glyphList)
+      cairo_glyph_free(glyphList);
+    return false;
+  }
+  cairo_glyph_t g = glyphList[0];
+  cairo_glyph_free(glyphList);
+
+  // No fontconfig fallback here, the whole title goes through renderText
+  if (g.index == 0) {
+    out.missing = true;
+    return true;
+  }
+
+  cairo_text_extents_t extents;
+  cairo_scaled_font_glyph_extents(font, &g, 1, &extents);
+  out.advance = extents.x_advance;
+
+  // Whitespace only advances
+  if (extents.width <= 0 || extents.height <= 0) {
+    out.size = {0, 0};
+    return true;
+  }
+
+  // 1px padding so linear sampling never bleeds into the neighbour
+  const int gx = (int)std::floor(extents.x_bearing) - 1;
+  const int gy = (int)std::floor(extents.y_bearing) - 1;
+  const int gw = (int)std::ceil(extents.x_bearing + extents.width) + 1 - gx;
+  const int gh = (int)std::ceil(extents.y_bearing + extents.height) + 1 - gy;
+
+  if (penX + gw + 1 > atlasSize) {
+    penX = 1;
+    penY += rowHeight + 1;
+    rowHeight = 0;
+  }
+  if (penY + gh + 1 > atlasSize || gw + 2 > atlasSize)
+    return false;
+
+  g.x = penX - gx;
+  g.y = penY - gy;
+  cairo_show_glyphs(cairo, &g, 1);
+
+  const double inv = 1.0 / atlasSize;
+  out.uv = {penX * inv, penY * inv, gw * inv, gh * inv};
+  out.offset = {(double)gx, (double)gy};
+  out.size = {(double)gw, (double)gh};
+  dirty.add(CBox{(double)penX, (double)penY, (double)gw, (double)gh});
+
+  penX += gw + 1;
+  rowHeight = std::max(rowHeight, gh);
+  return true;
+}
+
+const Glyph *GlyphAtlas::glyph(uint32_t codepoint, std::string_view utf8) {
+  if (auto it = glyphs.find(codepoint); it != glyphs.end())
+    return &it->second;
+
+  Glyph g;
+  if (!rasterize(g, codepoint, utf8)) {
+    // Atlas full: start over, callers notice through the generation
+    if (glyphs.empty())
+      return nullptr;
+    reset();
+    if (!rasterize(g, codepoint, utf8))
+      return nullptr;
+  }
+  return &glyphs.emplace(codepoint, g).first->second;
+}
+
+TitleLayout GlyphAtlas::layout(const std::string &text, float maxWidth) {
+  const auto chars = decodeUtf8(text);
+
+  // A reset halfway through invalidates the glyph pointers, so just redo it
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    const uint64_t startGen = gen;
+
+    std::vector<const Glyph *> line;
+    line.reserve(chars.size());
+    float total = 0.0f;
+    bool fallback = false;
+    for (const auto &[cp, bytes] : chars) {
+      if (needsShaping(cp)) {
+        fallback = true;
+        break;
+      }
+      const auto *g = glyph(cp, bytes);
+      if (!g)
+        continue;
+      if (g->missing) {
+        fallback = true;
+        break;
+      }
+      line.push_back(g);
+      total += g->advance;
+    }
+    const auto *dot = glyph('.', ".");
+    if (gen != startGen)
+      continue;
+    if (fallback)
+      return {.generation = gen, .fallback = true};
+
+    size_t left = line.size(), right = line.size();
+    bool truncated = false;
+    if (total > maxWidth && dot) {
+      // Measured middle ellipsis: take glyphs alternately from both ends while they fit
+      truncated = true;
+      float budget = maxWidth - dot->advance * 3.0f;
+      left = 0;
+      bool fromLeft = true;
+      while (left < right) {
+        const Glyph *next = fromLeft ? line[left] : line[right - 1];
+        const Glyph *other = fromLeft ? line[right - 1] : line[left];
+        if (next->advance <= budget) {
+          budget -= next->advance;
+          fromLeft ? left++ : right--;
+        } else if (other->advance <= budget) {
+          budget -= other->advance;
+          fromLeft ? right-- : left++;
+        } else
+          break;
+        fromLeft = !fromLeft;
+      }
+    }
+
+    TitleLayout out;
+    out.generation = gen;
+    out.quads.reserve(left + (line.size() - right) + 3);
+    float pen = 0.0f;
+    auto emit = [&](const Glyph *g) {
+      if (g->size.x > 0)
+        out.quads.push_back({CBox{pen + g->offset.x, ascent + g->offset.y, g->size.x, g->size.y}, g->uv});
+      pen += g->advance;
+    };
+
+    for (size_t i = 0; i < left; ++i)
+      emit(line[i]);
+    if (truncated)
+      for (int i = 0; i < 3; ++i)
+        emit(dot);
+    for (size_t i = right; i < line.size(); ++i)
+      emit(line[i]);
+
+    out.size = {std::ceil(pen), std::ceil(lineHeight)};
+    return out;
+  }
+
+  return {};
+}
+
+SP<CTexture> GlyphAtlas::texture() {
+  if (dirty.empty() && tex)
+    return tex;
+
+  cairo_surface_flush(surface);
+  auto *data = cairo_image_surface_get_data(surface);
+  const auto stride = cairo_image_surface_get_stride(surface);
+  if (!tex)
+    tex = makeShared<CTexture>(DRM_FORMAT_ARGB8888, data, stride, Vector2D{(double)atlasSize, (double)atlasSize});
+  else
+    tex->update(DRM_FORMAT_ARGB8888, data, stride, dirty);
+  dirty.clear();
+  return tex;
+}
+
+uint64_t GlyphAtlas::generation() const {
+  return gen;
+}
+
+GlyphAtlas &GlyphAtlas::get(int fontSize, float scale) {
+  const int pixelSize = std::max(1, (int)std::round(fontSize * scale));
+  auto it = atlases.find(pixelSize);
+  if (it != atlases.end()) {
+    it->second->lastUse = ++useClock;
+    return *it->second;
+  }
+
+  // Font size or scale changes are rare, don't keep an atlas for every value ever used. Outputs
+  // with different scales each keep theirs, only the one nobody asked for the longest goes.
+  if (atlases.size() >= 4) {
+    auto oldest = std::min_element(atlases.begin(), atlases.end(), [](const auto &a, const auto &b) { return a.second->lastUse < b.second->lastUse; });
+    LOG(Log::DRAW, "glyph atlas {}px evicted", oldest->first);
+    atlases.erase(oldest);
+  }
+  auto &atlas = atlases[pixelSize] = makeUnique<GlyphAtlas>(pixelSize);
+  atlas->lastUse = ++useClock;
+  return *atlas;
+}
+
+void GlyphAtlas::clearAll() {
+  atlases.clear();
+}
+
+TitleShader::~TitleShader() {
+  if (vbo)
+    glDeleteBuffers(1, &vbo);
+  if (vao)
+    glDeleteVertexArrays(1, &vao);
+  if (program)
+    glDeleteProgram(program);
+}
+
+TitleShader *TitleShader::get() {
+  if (instance)
+    return instance.get();
+  if (failed)
+    return nullptr;
+
+  auto shader = makeUnique<TitleShader>();
+  if (!shader->compile()) {
+    // Per glyph renderTexture it is then
+    failed = true;
+    return nullptr;
+  }
+  instance = std::move(shader);
+  return instance.get();
+}
+
+void TitleShader::destroy() {
+  instance.reset();
+  failed = false;
+}
+
+bool TitleShader::compile() {
+  program = compileProgram(TITLE_VERT, TITLE_FRAG);
+  if (!program)
+    return false;
+
+  loc.proj = glGetUniformLocation(program, "proj");
+  loc.tex = glGetUniformLocation(program, "tex");
+  loc.alpha = glGetUniformLocation(program, "alpha");
+
+  glGenVertexArrays(1, &vao);
+  glGenBuffers(1, &vbo);
+  glBindVertexArray(vao);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), nullptr);
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void *)(2 * sizeof(GLfloat)));
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  return true;
+}
+
+void TitleShader::draw(const SP<CTexture> &tex, const TitleLayout &layout, const Vector2D &pos, float a, const CRegion &damage) {
+  auto &rd = g_pHyprOpenGL->m_renderData;
+  CBox box = {pos, layout.size};
+  if (box.w <= 0 || box.h <= 0 || !rd.pMonitor)
+    return;
+
+  // Glyph padding can poke a pixel out of the line box
+  CRegion clip = damage.copy().intersect(box.copy().expand(2));
+  if (clip.empty())
+    return;
+
+  // Two triangles per glyph, positions relative to the line box so one matrix places them all
+  verts.clear();
+  verts.reserve(layout.quads.size() * 24);
+  for (const auto &quad : layout.quads) {
+    const float x0 = quad.box.x / box.w, y0 = quad.box.y / box.h;
+    const float x1 = (quad.box.x + quad.box.w) / box.w, y1 = (quad.box.y + quad.box.h) / box.h;
+    const float u0 = quad.uv.x, v0 = quad.uv.y, u1 = quad.uv.x + quad.uv.w, v1 = quad.uv.y + quad.uv.h;
+    verts.insert(verts.end(), {x0, y0, u0, v0, x1, y0, u1, v0, x0, y1, u0, v1,
+                               x1, y0, u1, v0, x1, y1, u1, v1, x0, y1, u0, v1});
+  }
+
+  rd.renderModif.applyToBox(box);
+  const auto TRANSFORM = Math::wlTransformToHyprutils(
+      Math::invertTransform(!g_pHyprOpenGL->m_monitorTransformEnabled ? WL_OUTPUT_TRANSFORM_NORMAL : rd.pMonitor->m_transform));
+  Mat3x3 matrix = rd.monitorProjection.projectBox(box, TRANSFORM, box.rot);
+  Mat3x3 glMatrix = rd.projection.copy().multiply(matrix);
+
+  g_pHyprOpenGL->blend(true);
+  g_pHyprOpenGL->useProgram(program);
+
+  glUniformMatrix3fv(loc.proj, 1, GL_TRUE, glMatrix.getMatrix().data());
+  glUniform1f(loc.alpha, a);
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(tex->m_target, tex->m_texID);
+  glTexParameteri(tex->m_target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(tex->m_target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glUniform1i(loc.tex, 0);
+
+  glBindVertexArray(vao);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(GLfloat), verts.data(), GL_STREAM_DRAW);
+  const GLsizei count = (GLsizei)(verts.size() / 4);
+  clip.forEachRect([count](const auto &RECT) {
+    g_pHyprOpenGL->scissor(&RECT);
+    glDrawArrays(GL_TRIANGLES, 0, count);
+  });
+  g_pHyprOpenGL->scissor(nullptr);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+  glBindTexture(tex->m_target, 0);
+}
+
+void alttab::renderTitle(const SP<CTexture> &tex, const TitleLayout &layout, const Vector2D &pos, float a, const CRegion &damage) {
+  if (!tex || layout.quads.empty())
+    return;
+
+  if (auto *shader = TitleShader::get()) {
+    shader->draw(tex, layout, pos, a, damage);
+    return;
+  }
+
+  auto &rd = g_pHyprOpenGL->m_renderData;
+  for (const auto &quad : layout.quads) {
+    const CBox box = quad.box.copy().translate(pos);
+    rd.primarySurfaceUVTopLeft = quad.uv.pos();
+    rd.primarySurfaceUVBottomRight = quad.uv.pos() + quad.uv.size();
+    g_pHyprOpenGL->renderTexture(tex, box, {.damage = &damage, .a = a, .allowCustomUV = true});
+  }
+  rd.primarySurfaceUVTopLeft = Vector2D(-1, -1);
+  rd.primarySurfaceUVBottomRight = Vector2D(-1, -1);
+}
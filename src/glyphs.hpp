@@ -0,0 +1,110 @@
+#pragma once
+#include "cardshader.hpp"
+#include "defines.hpp"
+#include <cairo/cairo.h>
+#include <map>
+#include <src/render/Texture.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace alttab {
+
+struct Glyph {
+  CBox uv;          // normalized rect inside the atlas
+  Vector2D offset;  // top-left of the quad relative to the pen position on the baseline
+  Vector2D size;    // quad size in pixels
+  float advance = 0;
+  // Glyph index 0, the face doesn't have it
+  bool missing = false;
+};
+
+struct GlyphQuad {
+  CBox box; // relative to the top-left of the text line
+  CBox uv;
+};
+
+struct TitleLayout {
+  std::vector<GlyphQuad> quads;
+  Vector2D size;
+  uint64_t generation = 0;
+  // The toy font can't do it (missing glyphs, shaping, combining marks), draw with renderText instead
+  bool fallback = false;
+};
+
+// One atlas per font pixel size (font_size * monitor scale). Glyphs are rasterized once
+// with cairo, titles are measured from cached advances and drawn as quads from the atlas.
+class GlyphAtlas {
+public:
+  GlyphAtlas(int pixelSize);
+  ~GlyphAtlas();
+
+  // Middle-ellipsis truncated to maxWidth (pixels), using measured advances. Comes back
+  // empty with fallback set when the atlas can't draw the text properly.
+  TitleLayout layout(const std::string &text, float maxWidth);
+  // Uploads pending glyphs. Only sub-rects that changed are sent.
+  SP<CTexture> texture();
+  uint64_t generation() const;
+
+  static GlyphAtlas &get(int fontSize, float scale);
+  static void clearAll();
+
+private:
+  const Glyph *glyph(uint32_t codepoint, std::string_view utf8);
+  bool rasterize(Glyph &out, uint32_t codepoint, std::string_view utf8);
+  void reset();
+
+  int pixelSize = 0;
+  int atlasSize = 0;
+  float ascent = 0, lineHeight = 0;
+
+  cairo_surface_t *surface = nullptr;
+  cairo_t *cairo = nullptr;
+  cairo_scaled_font_t *font = nullptr;
+
+  std::unordered_map<uint32_t, Glyph> glyphs;
+  int penX = 0, penY = 0, rowHeight = 0;
+
+  SP<CTexture> tex;
+  CRegion dirty;
+  // Bumped whenever the atlas is wiped, cached layouts from an older generation are invalid
+  uint64_t gen = 1;
+  // get() call count at the last lookup, the oldest atlas is evicted first
+  uint64_t lastUse = 0;
+
+  static inline std::map<int, UP<GlyphAtlas>> atlases;
+  static inline uint64_t useClock = 0;
+};
+
+// Draws a whole title in one call: its quads go into a stream buffer as triangles
+class TitleShader {
+public:
+  ~TitleShader();
+
+  // Compiles lazily on first use, nullptr if the driver refused the shader
+  static TitleShader *get();
+  static void destroy();
+
+  void draw(const SP<CTexture> &tex, const TitleLayout &layout, const Vector2D &pos, float a, const CRegion &damage);
+
+private:
+  bool compile();
+
+  GLuint program = 0;
+  GLuint vao = 0;
+  GLuint vbo = 0;
+  struct {
+    GLint proj = -1;
+    GLint tex = -1;
+    GLint alpha = -1;
+  } loc;
+  // Reused between titles, interleaved pos / uv
+  std::vector<GLfloat> verts;
+
+  static inline UP<TitleShader> instance;
+  static inline bool failed = false;
+};
+
+// Draws a laid out title with its top-left at pos, all quads sample the same atlas texture
+void renderTitle(const SP<CTexture> &tex, const TitleLayout &layout, const Vector2D &pos, float a, const CRegion &damage);
+
+} // namespace alttab
@@ -10,12 +10,39 @@ struct simd4x4 {
   float x[4], y[4], z[4], scale[4];
 };
 
+// Taylor series, only accurate in [-pi/2, pi/2]. Use fast_sincos_ps for anything else.
 inline __m128 fast_sin_ps(__m128 x) {
   __m128 x2 = _mm_mul_ps(x, x);
   __m128 x3 = _mm_mul_ps(x2, x);
-  __m128 x5 = _mm_mul_ps(_mm_mul_ps(x3, x2), _mm_set1_ps(1.0f / 120.0f));
+  __m128 x5 = _mm_mul_ps(x3, x2);
+  __m128 x7 = _mm_mul_ps(_mm_mul_ps(x5, x2), _mm_set1_ps(1.0f / 5040.0f));
+  x5 = _mm_mul_ps(x5, _mm_set1_ps(1.0f / 120.0f));
   x3 = _mm_mul_ps(x3, _mm_set1_ps(1.0f / 6.0f));
-  return _mm_add_ps(_mm_sub_ps(x, x3), x5);
+  return _mm_sub_ps(_mm_add_ps(_mm_sub_ps(x, x3), x5), x7);
+}
+
+inline __m128 select_ps(__m128 mask, __m128 a, __m128 b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Wraps x into [-pi, pi] and folds it onto [-pi/2, pi/2] where sin is symmetric
+inline __m128 fold_sin_arg_ps(__m128 x) {
+  const __m128 PI = _mm_set1_ps((float)M_PI);
+  const __m128 HALF_PI = _mm_set1_ps((float)M_PI_2);
+  const __m128 TWO_PI = _mm_set1_ps(2.0f * (float)M_PI);
+
+  const __m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.5f / (float)M_PI))));
+  x = _mm_sub_ps(x, _mm_mul_ps(turns, TWO_PI));
+
+  const __m128 negPI = _mm_sub_ps(_mm_setzero_ps(), PI);
+  x = select_ps(_mm_cmpgt_ps(x, HALF_PI), _mm_sub_ps(PI, x), x);
+  x = select_ps(_mm_cmplt_ps(x, _mm_sub_ps(_mm_setzero_ps(), HALF_PI)), _mm_sub_ps(negPI, x), x);
+  return x;
+}
+
+inline void fast_sincos_ps(__m128 x, __m128 &s, __m128 &c) {
+  s = fast_sin_ps(fold_sin_arg_ps(x));
+  c = fast_sin_ps(fold_sin_arg_ps(_mm_add_ps(x, _mm_set1_ps((float)M_PI_2))));
 }
 
 inline std::string middleTruncate(std::string str, size_t maxLen = 40) {
@@ -24,7 +51,13 @@ inline std::string middleTruncate(std::string str, size_t maxLen = 40) {
   maxLen = std::max((int)maxLen, 5);
 
   size_t sideLen = (maxLen - 3) / 2;
-  return str.substr(0, sideLen) + "..." + str.substr(str.length() - sideLen);
+  // Don't cut a UTF-8 sequence in half
+  size_t left = sideLen, right = str.length() - sideLen;
+  while (left > 0 && ((unsigned char)str[left] & 0xC0) == 0x80)
+    left--;
+  while (right < str.length() && ((unsigned char)str[right] & 0xC0) == 0x80)
+    right++;
+  return str.substr(0, left) + "..." + str.substr(right);
 }
 
 inline std::string toLower(std::string_view str) {
@@ -17,6 +17,7 @@ enum LogType : uint32_t {
   MOUSE = 1 << 6,
   DAMAGE = 1 << 7,
   STYLE = 1 << 8,
+  BACKGROUND = 1 << 9,
   ALL = 0xFFFFFFFF
 };
 
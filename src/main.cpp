@@ -1,4 +1,7 @@
 #include "defines.hpp"
+#include "cardshader.hpp"
+#include "glyphs.hpp"
+#include "snapshot.hpp"
 #include "manager.hpp"
 #include <hyprutils/memory/UniquePtr.hpp>
 #include <src/config/ConfigDataValues.hpp>
@@ -239,4 +242,9 @@ APICALL EXPORT void PLUGIN_EXIT() {
   keyhookfn = nullptr;
   workspacehookfn = nullptr;
   manager.reset();
+  alttab::GlyphAtlas::clearAll();
+  alttab::CardShader::destroy();
+  alttab::TitleShader::destroy();
+  alttab::CardSnapshot::destroy();
+  alttab::Background::destroy();
 }
@@ -4,6 +4,8 @@
 #include "logger.hpp"
 #include <aquamarine/output/Output.hpp>
 #include <chrono>
+#include <cmath>
+#include <unordered_set>
 #include <hyprutils/math/Vector2D.hpp>
 #include <src/Compositor.hpp>
 #include <src/desktop/history/WindowHistoryTracker.hpp>
@@ -11,6 +13,7 @@
 #include <src/helpers/Color.hpp>
 #include <src/helpers/Monitor.hpp>
 #include <src/managers/PointerManager.hpp>
+#include <src/managers/animation/AnimationManager.hpp>
 #include <src/managers/eventLoop/EventLoopManager.hpp>
 #include <src/managers/input/InputManager.hpp>
 #include <src/plugins/PluginAPI.hpp>
@@ -30,18 +33,26 @@ static int lastCounter = 0;
 
 using namespace alttab;
 
-Manager::Manager() : monitorOffset(&Config::monitorAnimationSpeed),
-                     monitorFade(&Config::monitorFade) {
+// One prewarm step per tick, so the grace period never sees a long stall
+static constexpr auto PREWARM_STEP = std::chrono::milliseconds(4);
+static constexpr size_t PREWARM_TITLES = 4;
+
+Manager::Manager() : monitorOffset(&Config::monitorAnimationSpeed, &Curves::monitor),
+                     monitorFade(&Config::monitorFade, &Curves::fade) {
   LOG_SCOPE()
 
 #ifdef HYPRLAND_LEGACY
   listeners.config = HyprlandAPI::registerCallbackDynamic(PHANDLE, "configReloaded", [this](void *self, SCallbackInfo &info, std::any data) { onConfigReload(); });
   listeners.windowCreated = HyprlandAPI::registerCallbackDynamic(PHANDLE, "openWindow", [this](void *self, SCallbackInfo &info, std::any data) { onWindowCreated(std::any_cast<PHLWINDOW>(data)); });
   listeners.windowDestroyed = HyprlandAPI::registerCallbackDynamic(PHANDLE, "closeWindow", [this](void *self, SCallbackInfo &info, std::any data) { onWindowDestroyed(std::any_cast<PHLWINDOW>(data)); });
+  listeners.windowFocused = HyprlandAPI::registerCallbackDynamic(PHANDLE, "activeWindow", [this](void *self, SCallbackInfo &info, std::any data) { onWindowFocused(std::any_cast<PHLWINDOW>(data)); });
+  listeners.windowTitle = HyprlandAPI::registerCallbackDynamic(PHANDLE, "windowTitle", [this](void *self, SCallbackInfo &info, std::any data) { onWindowTitle(std::any_cast<PHLWINDOW>(data)); });
+  listeners.windowMoved = HyprlandAPI::registerCallbackDynamic(PHANDLE, "moveWindow", [this](void *self, SCallbackInfo &info, std::any data) { onWindowMoved(std::any_cast<PHLWINDOW>(std::any_cast<std::vector<std::any>>(data).at(0))); });
   listeners.render = HyprlandAPI::registerCallbackDynamic(PHANDLE, "render", [this](void *self, SCallbackInfo &info, std::any data) { onRender(std::any_cast<eRenderStage>(data)); });
+  listeners.preRender = HyprlandAPI::registerCallbackDynamic(PHANDLE, "preRender", [this](void *self, SCallbackInfo &info, std::any data) { renderOutput = std::any_cast<PHLMONITOR>(data); });
   listeners.focusChange = HyprlandAPI::registerCallbackDynamic(PHANDLE, "monitorFocusChange", [this](void *self, SCallbackInfo &info, std::any data) { onFocusChange(std::any_cast<PHLMONITOR>(data)); });
-  listeners.monitorAdded = HyprlandAPI::registerCallbackDynamic(PHANDLE, "monitorAdded", [this](void *self, SCallbackInfo &info, std::any data) { rebuild(); });
-  listeners.monitorRemoved = HyprlandAPI::registerCallbackDynamic(PHANDLE, "monitorRemoved", [this](void *self, SCallbackInfo &info, std::any data) { rebuild(); });
+  listeners.monitorAdded = HyprlandAPI::registerCallbackDynamic(PHANDLE, "monitorAdded", [this](void *self, SCallbackInfo &info, std::any data) { requestRebuild(); });
+  listeners.monitorRemoved = HyprlandAPI::registerCallbackDynamic(PHANDLE, "monitorRemoved", [this](void *self, SCallbackInfo &info, std::any data) { requestRebuild(); });
 #else
   listeners.config = HOOK_EVENT(config.reloaded, [this]() {
     onConfigReload();
@@ -52,17 +63,29 @@ Manager::Manager() : monitorOffset(&Config::monitorAnimationSpeed),
   listeners.windowDestroyed = HOOK_EVENT(window.close, [this](auto w) {
     onWindowDestroyed(w);
   });
+  listeners.windowFocused = HOOK_EVENT(window.active, [this](auto w, auto &&...) {
+    onWindowFocused(w);
+  });
+  listeners.windowTitle = HOOK_EVENT(window.title, [this](auto w, auto &&...) {
+    onWindowTitle(w);
+  });
+  listeners.windowMoved = HOOK_EVENT(window.moveToWorkspace, [this](auto w, auto &&...) {
+    onWindowMoved(w);
+  });
   listeners.render = HOOK_EVENT(render.stage, [this](auto s) {
     onRender(s);
   });
+  listeners.preRender = HOOK_EVENT(render.pre, [this](auto m) {
+    renderOutput = m;
+  });
   listeners.focusChange = HOOK_EVENT(monitor.focused, [this](auto m) {
     onFocusChange(m);
   });
   listeners.monitorAdded = HOOK_EVENT(monitor.added, [this](auto m) {
-    rebuild();
+    requestRebuild();
   });
   listeners.monitorRemoved = HOOK_EVENT(monitor.removed, [this](auto m) {
-    rebuild();
+    requestRebuild();
   });
   listeners.mouseClick = HOOK_EVENT(input.mouse.button, [this](auto button, auto &cbInfo) {
     // cbInfo is only for .cancelled
@@ -89,11 +112,115 @@ void Manager::damageMonitors() {
   }
 }
 
+// Frames are requested only when something changed: animations in flight, surface commits or input.
+void Manager::scheduleFrame() {
+  if (!active)
+    return;
+
+  if (Config::splitMonitor) {
+    if (const auto MONITOR = Desktop::focusState()->monitor(); MONITOR)
+      g_pCompositor->scheduleFrameForMonitor(MONITOR);
+    return;
+  }
+
+  for (auto &[id, mon] : monitors) {
+    g_pCompositor->scheduleFrameForMonitor(mon->monitor);
+  }
+}
+
+// Live preview commit: only the preview of that card is redrawn, even while the layout is idle
+void Manager::damagePreview(const WindowCard *card) {
+  if (!active || !graceExpired || !card)
+    return;
+
+  CBox box = card->buildLayout(1.0f).preview;
+  if (box.empty())
+    return;
+
+  const auto OUTPUT = Config::splitMonitor ? Desktop::focusState()->monitor() : card->output.lock();
+  if (!OUTPUT)
+    return;
+
+  g_pHyprRenderer->damageBox(box.translate(OUTPUT->m_position));
+  if (!previewFramePending) {
+    previewFramePending = true;
+    g_pCompositor->scheduleFrameForMonitor(OUTPUT);
+  }
+}
+
+// Throttled cards mostly get their frame callbacks between rendered frames: their commits
+// damage only their preview (damagePreview), so nothing else has to be drawn for them.
+void Manager::armPresentTimer() {
+  if (!Config::livePreview)
+    return;
+
+  std::optional<Timestamp> next;
+  for (auto &[id, mon] : monitors)
+    for (const auto &task : mon->renderTasks)
+      if (const auto due = task.card ? task.card->nextPresent() : std::nullopt; due && (!next || *due < *next))
+        next = due;
+
+  if (!presentTimer) {
+    presentTimer = makeShared<CEventLoopTimer>(std::nullopt, [this](SP<CEventLoopTimer> timer, void *data) { presentThrottled(); }, nullptr);
+    g_pEventLoopManager->addTimer(presentTimer);
+  }
+  if (!next) {
+    presentTimer->updateTimeout(std::nullopt);
+    return;
+  }
+  const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(*next - NOW);
+  presentTimer->updateTimeout(std::max(wait, std::chrono::milliseconds(1)));
+}
+
+// Next vblank after now on a fixed refresh output. With VRR the frame goes out once it's
+// done, but never sooner than one period at the highest rate after the last one.
+Timestamp Manager::predictPresent(PHLMONITOR output) const {
+  const auto now = NOW;
+  if (!output || output->m_refreshRate <= 0.0f)
+    return now;
+
+  const double period = 1.0 / output->m_refreshRate;
+  const double since = output->m_lastPresentationTimer.getSeconds();
+  double wait = 0.0;
+  if (output->m_vrrActive)
+    wait = std::max(0.0, period - since);
+  else
+    wait = period - std::fmod(since, period);
+
+  return now + std::chrono::duration_cast<Timestamp::duration>(std::chrono::duration<double>(wait));
+}
+
+void Manager::presentThrottled() {
+  if (!active || !graceExpired)
+    return;
+
+  const auto now = NOW;
+  for (auto &[id, mon] : monitors)
+    for (auto &task : mon->renderTasks)
+      if (task.card && task.card->window && task.card->presentInterval > 0.0f)
+        task.card->presentIfDue(now);
+  armPresentTimer();
+}
+
+void Manager::invalidateBackground(PHLWINDOW window) {
+  backgrounds.invalidate(window);
+}
+
 void Manager::activate() {
   LOG_SCOPE()
   active = true;
+  graceExpired = false;
+  mru.clear();
+  mruCursor = 1;
   graceTimer = makeShared<CEventLoopTimer>(std::chrono::milliseconds(Config::grace), [this](SP<CEventLoopTimer> timer, void *data) { this->init(); }, nullptr);
   g_pEventLoopManager->addTimer(graceTimer);
+
+  // A quick tap is released before the first step and costs nothing
+  prewarm = Prewarm::CARDS;
+  prewarmCursor = 0;
+  const auto firstStep = std::max(std::chrono::milliseconds(Config::grace / 4), std::chrono::milliseconds(1));
+  prewarmTimer = makeShared<CEventLoopTimer>(firstStep, [this](SP<CEventLoopTimer> timer, void *data) { this->prewarmStep(); }, nullptr);
+  g_pEventLoopManager->addTimer(prewarmTimer);
 }
 
 bool Manager::setLayout() {
@@ -113,10 +240,20 @@ bool Manager::setLayout() {
 
 void Manager::init() {
   graceExpired = true;
+  if (prewarmTimer)
+    prewarmTimer->cancel();
   activeMonitor = Desktop::focusState()->monitor()->m_id;
   monitorFade.set(1.0f, false);
   stack.clear();
-  rebuild();
+  if (resident)
+    reuseResident();
+  else if (prewarm > Prewarm::CARDS)
+    adoptPrewarm();
+  else
+    rebuild();
+  prewarm = Prewarm::IDLE;
+  resident = false;
+  applyGraceCursor();
   lastFrame = NOW;
   OVERRIDE_WORKSPACE = true;
   damageMonitors();
@@ -126,12 +263,28 @@ void Manager::deactivate() {
   LOG_SCOPE()
   active = false;
   graceTimer->cancel();
-  for (const auto &[id, mon] : monitors) {
-    g_pHyprRenderer->damageMonitor(mon->monitor);
+  // Prewarmed cards were never drawn, there is nothing to clean up on screen
+  if (graceExpired) {
+    for (const auto &[id, mon] : monitors) {
+      backgrounds.settle(id);
+      g_pHyprRenderer->damageMonitor(mon->monitor);
+    }
   }
   graceTimer.reset();
+  if (prewarmTimer)
+    prewarmTimer->cancel();
+  prewarmTimer.reset();
+  prewarm = Prewarm::IDLE;
+  if (presentTimer)
+    presentTimer->cancel();
+  presentTimer.reset();
   stack.clear();
-  monitors.clear();
+  captureQueue.clear();
+  pendingMoves.clear();
+  // Resident mode keeps cards and title textures around for the next activation
+  resident = Config::resident && !monitors.empty();
+  if (!resident)
+    monitors.clear();
   OVERRIDE_WORKSPACE = false;
 }
 
@@ -152,10 +305,15 @@ void Manager::confirm() {
     return Desktop::focusState()->window();
   };
 
+  // Presses that came in after the last frame still count
+  applyMoves();
+
   PHLWINDOWREF selected;
   bool hasMonitor = monitors.contains(activeMonitor);
 
-  if (!hasMonitor || !monitors[activeMonitor] || monitors[activeMonitor]->windows.empty()) {
+  if (!graceExpired && mruCursor < mru.size()) {
+    selected = mru[mruCursor];
+  } else if (!hasMonitor || !monitors[activeMonitor] || monitors[activeMonitor]->windows.empty()) {
     selected = getFallbackWindow();
   } else if (graceExpired) {
     const auto &mon = monitors[activeMonitor];
@@ -165,6 +323,12 @@ void Manager::confirm() {
   }
 
   if (selected) {
+    // Focus moves, so borders and stacking on both workspaces change
+    if (const auto PREV = Desktop::focusState()->window(); PREV != selected.lock()) {
+      backgrounds.invalidate(PREV);
+      backgrounds.invalidate(selected.lock());
+    }
+
     if (Config::bringToActive && selected->m_workspace)
       g_pKeybindManager->m_dispatchers["focusworkspaceoncurrentmonitor"](selected->m_workspace->m_name);
 
@@ -180,12 +344,13 @@ void Manager::confirm() {
   deactivate();
 }
 
-void Manager::update(float delta) {
+void Manager::update(float delta, Timestamp presentAt, PHLMONITOR output) {
   LOG_SCOPE(Log::UPDATE)
   const auto MONITOR = Desktop::focusState()->monitor();
   const Vector2D monitorPos = MONITOR->m_position;
-  const bool animating = AnimationManager::get().tick(delta) || stack.empty();
+  const bool animating = AnimationManager::get().tick(presentAt) || stack.empty();
   const float spacing = MONITOR->m_size.y * Config::monitorSpacing;
+  needsFrame = animating;
 
   //if not animating and we have cached state, skip layout math
   if (!animating && !stack.empty()) {
@@ -193,13 +358,13 @@ void Manager::update(float delta) {
     if (wasAnimating) {
       wasAnimating = false;
       CRegion damage;
-      for (auto &[id, mon] : monitors) {
-        if (!mon->cachedGlobalBounds.empty())
-          damage.add(mon->cachedGlobalBounds);
+      for (auto &[id, mon] : monitors)
+        damage.add(mon->cachedDamage.copy().translate(Config::splitMonitor ? monitorPos : mon->monitor->m_position));
+      for (auto &[id, ring] : damageHistory) {
+        ring.addTo(damage);
+        ring.clear();
       }
-      damage.add(previousFrameDamage);
       g_pHyprRenderer->damageRegion(damage);
-      previousFrameDamage = {};
     }
     // Fully idle — no damage submission, GPU sleeps Intel 4000HD said thanks;
     lastFrame = NOW;
@@ -209,16 +374,18 @@ void Manager::update(float delta) {
   wasAnimating = true;
 
   stack.clear();
-  CRegion damage;
   int i = 0;
   for (auto &[id, mon] : monitors) {
     CRegion mDamage;
-    float off = (i - monitorOffset.current) * spacing;
+    float off = (i - monitorOffset.current()) * spacing;
     mon->position = {monitorPos.x, monitorPos.y + off, MONITOR->m_pixelSize.x, MONITOR->m_pixelSize.y};
-    float z = (id == activeMonitor) ? 1000.0f : -std::abs(i - monitorOffset.current);
+    float z = (id == activeMonitor) ? 1000.0f : -std::abs(i - monitorOffset.current());
     if (animating)
       mon->update(delta, off, mDamage);
-    damage.add(mDamage);
+    // Cards are laid out monitor local, on the focused output when split
+    const auto OUTPUT = Config::splitMonitor ? MONITOR : mon->monitor;
+    mDamage.translate(OUTPUT->m_position);
+    damageHistory[OUTPUT->m_id].pending.add(mDamage);
     i++;
     stack.push_back({.monitor = mon.get(), .offset = off, .z = z});
   }
@@ -226,20 +393,102 @@ void Manager::update(float delta) {
     return a.z < b.z;
   });
   lastFrame = NOW;
-  CRegion total = damage;
-  total.add(previousFrameDamage);
-  g_pHyprRenderer->damageRegion(total);
-  if (animating)
-    previousFrameDamage = damage;
+
+  // Per output, as deep as its swapchain. Only the output being rendered moves on to its next
+  // buffer, the others keep their pending damage (submitted, so they get a frame) until they do.
+  for (auto &[id, ring] : damageHistory) {
+    const auto OUTPUT = g_pCompositor->getMonitorFromID(id);
+    if (!OUTPUT)
+      continue;
+    if (OUTPUT != output) {
+      g_pHyprRenderer->damageRegion(ring.pending);
+      continue;
+    }
+    size_t length = 2;
+    if (OUTPUT->m_output && OUTPUT->m_output->swapchain)
+      length = OUTPUT->m_output->swapchain->currentOptions().length;
+    ring.setDepth(length > 1 ? length - 1 : 1);
+
+    CRegion total;
+    ring.addTo(total);
+    g_pHyprRenderer->damageRegion(total);
+    ring.push();
+  }
+  std::erase_if(damageHistory, [](const auto &entry) { return !g_pCompositor->getMonitorFromID(entry.first); });
 }
 
+// Key repeat can deliver several presses per frame, they're queued and applied together
+// in RENDER_PRE so the rotation is retargeted once instead of restarting on every press.
 void Manager::move(Direction dir) {
   LOG_SCOPE(Log::MOVE)
 
+  if (!graceExpired) {
+    cycleGrace(dir);
+    return;
+  }
+
+  pendingMoves.push_back(dir);
+  scheduleFrame();
+}
+
+void Manager::applyMoves(std::vector<WindowCard *> *affected) {
+  if (pendingMoves.empty())
+    return;
+  LOG_SCOPE(Log::MOVE)
+  LOG(Log::MOVE, "applying {} queued moves", pendingMoves.size());
+
+  std::vector<alttab::Monitor *> touched;
+  for (const auto dir : pendingMoves) {
+    auto *mon = step(dir);
+    if (mon && std::ranges::find(touched, mon) == touched.end())
+      touched.push_back(mon);
+  }
+  pendingMoves.clear();
+
+  for (auto *mon : touched) {
+    if (affected)
+      affected->push_back(mon->activeCard);
+    mon->activeChanged();
+    if (affected)
+      affected->push_back(mon->activeCard);
+  }
+}
+
+// Presses that land between RENDER_PRE and submission. Positions stay as laid out, but the
+// old and new card get this frame's highlight and border instead of waiting a frame.
+void Manager::latchMoves(PHLMONITOR output, CRegion &damage) {
+  LOG_SCOPE(Log::MOVE)
+  // Rotation towards the new card starts with the next frame
+  needsFrame = true;
+
+  // Without a background the area outside this frame's damage can't be painted over. The
+  // presses stay queued for the next RENDER_PRE instead of showing half a highlight change.
+  const auto it = monitors.find(output->m_id);
+  if (it == monitors.end() || !it->second->backgroundReady())
+    return;
+
+  std::vector<WindowCard *> affected;
+  applyMoves(&affected);
+  for (auto *card : affected) {
+    if (!card || card->lastBox.empty())
+      continue;
+    const auto OUTPUT = Config::splitMonitor ? Desktop::focusState()->monitor() : card->output.lock();
+    if (!OUTPUT)
+      continue;
+    // The frame's damage was computed before this, so it's widened here for the pass. The ring
+    // gets the same area, older buffers still have the old highlight and catch up from it.
+    damageHistory[OUTPUT->m_id].pending.add(card->lastBox.copy().translate(OUTPUT->m_position));
+    if (OUTPUT == output)
+      damage.add(card->lastBox.copy().scale(output->m_scale).round());
+  }
+}
+
+// One navigation step. Only the index moves here, returns the monitor whose selection changed.
+alttab::Monitor *Manager::step(Direction dir) {
   auto it = monitors.find(activeMonitor);
   if (it == monitors.end()) {
     if (monitors.empty())
-      return;
+      return nullptr;
     it = monitors.begin();
   }
 
@@ -247,11 +496,15 @@ void Manager::move(Direction dir) {
   const auto res = layoutStyle->onMove(dir, mon->activeWindow, mon->windows.size());
 
   if (res.index.has_value() && !mon->windows.empty()) {
+    const int count = mon->windows.size();
+    const int delta = (int)res.index.value() - (int)mon->activeWindow;
+    // Shortest way around the ring for a single step, the sum keeps the overall direction
+    mon->pendingSteps += (int)std::remainder(delta, count);
     mon->activeWindow = res.index.value();
-    mon->activeChanged();
+    return mon.get();
   } else if (res.changeMonitor) {
     if (monitors.size() < 2)
-      return;
+      return nullptr;
 
     if (dir == Direction::DOWN || dir == Direction::RIGHT) {
       it++;
@@ -267,6 +520,56 @@ void Manager::move(Direction dir) {
     activeMonitor = it->first;
     monitorOffset.set(activeMonitor);
   }
+  return nullptr;
+}
+
+// Tab presses before the UI shows only walk the MRU list, nothing is captured or drawn.
+// Each press restarts the grace timer so the carousel only appears once the user hesitates.
+void Manager::cycleGrace(Direction dir) {
+  LOG_SCOPE(Log::MOVE)
+  if (dir == Direction::UP || dir == Direction::DOWN)
+    return;
+
+  if (mru.empty()) {
+    const auto history = Desktop::History::windowTracker()->fullHistory();
+    for (auto it = history.rbegin(); it != history.rend(); ++it) {
+      const auto w = it->lock();
+      if (w && w->m_isMapped && (Config::includeSpecial || !w->m_workspace || !w->m_workspace->m_isSpecialWorkspace))
+        mru.emplace_back(w);
+    }
+  }
+  if (mru.size() < 2)
+    return;
+
+  mruCursor = (dir == Direction::LEFT) ? (mruCursor + mru.size() - 1) % mru.size() : (mruCursor + 1) % mru.size();
+  LOG(Log::MOVE, "grace cursor: {}/{}", mruCursor, mru.size());
+
+  if (graceTimer)
+    graceTimer->updateTimeout(std::chrono::milliseconds(Config::grace));
+}
+
+// Carry the selection made during the grace period over to the carousel
+void Manager::applyGraceCursor() {
+  if (mruCursor >= mru.size())
+    return;
+  const auto TARGET = mru[mruCursor].lock();
+  if (!TARGET)
+    return;
+
+  for (auto &[id, mon] : monitors) {
+    auto it = std::find_if(mon->windows.begin(), mon->windows.end(), [&](const auto &card) { return card->window == TARGET; });
+    if (it == mon->windows.end())
+      continue;
+
+    if (id != activeMonitor) {
+      activeMonitor = id;
+      monitorOffset.snap(activeMonitor);
+    }
+    mon->activeWindow = std::distance(mon->windows.begin(), it);
+    mon->activeChanged();
+    mon->rotation.snap(mon->rotation.target());
+    return;
+  }
 }
 
 void Manager::draw(MONITORID monid, const CRegion &damage) {
@@ -277,18 +580,18 @@ void Manager::renderBackground(MONITORID monid, const CRegion &damage) {
   if (!monitors.contains(monid))
     return;
   auto &mon = monitors[monid];
-  if (!mon->texture)
-    return;
-
-  auto tex = (Config::blurBG) ? mon->blurred : mon->texture;
   const auto box = CBox{{}, mon->monitor->m_pixelSize};
-  CTexPassElement::SRenderData data;
-  data.tex = tex;
-  data.box = box;
 
-  data.a = 1.0f;
-  data.damage = {};
-  g_pHyprRenderer->m_renderPass.add(makeUnique<CTexPassElement>(data));
+  // Until the staged capture reaches this output it only gets the dim overlay
+  if (mon->backgroundReady()) {
+    CTexPassElement::SRenderData data;
+    data.tex = (Config::blurBG) ? mon->background->blurred : mon->background->texture;
+    data.box = box;
+
+    data.a = 1.0f;
+    data.damage = {};
+    g_pHyprRenderer->m_renderPass.add(makeUnique<CTexPassElement>(data));
+  }
 
   //Dim overlay — deferred via CRectPassElement
   if (Config::dimEnabled) {
@@ -303,8 +606,21 @@ void Manager::renderMonitors(const CRegion &damage) {
   LOG_SCOPE(Log::DRAW)
   LOG(Log::DRAW, "stack size: {}", stack.size());
   for (auto &el : stack) {
-    el.monitor->draw(damage, monitorFade.current);
+    el.monitor->draw(cardBatch, damage, monitorFade.current());
+  }
+}
+
+// Named Hyprland bezier into a lookup table, unknown or empty names keep the built-in ease-out
+static void bakeCurve(CurveLUT &lut, Hyprlang::STRING conf) {
+  const std::string name = conf ? conf : "";
+  if (name.empty() || !g_pAnimationManager->bezierExists(name)) {
+    if (!name.empty())
+      LOG(Log::ANIMATE, "unknown bezier {}, using the default curve", name);
+    lut.reset();
+    return;
   }
+  const auto BEZIER = g_pAnimationManager->getBezier(name);
+  lut.bake([&](float t) { return BEZIER->getYForPoint(t); });
 }
 
 void Manager::onConfigReload() {
@@ -344,19 +660,65 @@ void Manager::onConfigReload() {
   Config::activeBorderColor = getGradient("plugin:alttab:border_active");
   Config::inactiveBorderColor = getGradient("plugin:alttab:border_inactive");
 
+  bakeCurve(Curves::rotation, Config::rotationCurve);
+  bakeCurve(Curves::monitor, Config::monitorCurve);
+  bakeCurve(Curves::fade, Config::fadeCurve);
+
   stack.clear();
+  // Filters and style may have changed, resident cards get rebuilt on the next activation
+  dropResident();
+  restartPrewarm();
 }
 
 void Manager::onWindowCreated(PHLWINDOW window) {
-  // TODO: add window to specific monitor
-  if (!active)
+  LOG_SCOPE()
+  // Before the grace period ends there's nothing built yet, init() will pick it up
+  if (!cardsLive() || !window)
     return;
 
-  rebuild();
+  if (Config::splitMonitor) {
+    const auto MONITOR = window->m_monitor.lock();
+    if (!MONITOR || !MONITOR->m_enabled || MONITOR->m_isUnsafeFallback)
+      return;
+    if (!monitors.contains(MONITOR->m_id)) {
+      // Its last window was closed earlier, so the monitor got dropped
+      if (!shouldShow(window, MONITOR))
+        return;
+      addMonitor(MONITOR, false);
+      if (!captureQueue.empty())
+        scheduleFrame();
+    }
+  }
+
+  const auto history = Desktop::History::windowTracker()->fullHistory();
+  for (auto &[id, mon] : monitors) {
+    if (!shouldShow(window, mon->monitor))
+      continue;
+
+    // MRU position = number of this monitor's cards focused more recently than the new window
+    std::unordered_set<decltype(window.get())> cards;
+    for (const auto &card : mon->windows)
+      cards.insert(card->window.get());
+    size_t index = 0;
+    for (auto it = history.rbegin(); it != history.rend(); ++it) {
+      const auto w = it->lock();
+      if (w == window)
+        break;
+      if (w && cards.contains(w.get()))
+        index++;
+    }
+
+    mon->insertWindow(window, index);
+  }
+
+  // Inserting behind the selection doesn't move the rotation target, without this the idle
+  // path would never lay out the new card
+  stack.clear();
+  scheduleFrame();
 }
 
 void Manager::onWindowDestroyed(PHLWINDOW window) {
-  if (!window || !active)
+  if (!window || !cardsLive())
     return;
 
   auto mon = window->m_monitor.lock();
@@ -374,27 +736,70 @@ void Manager::onWindowDestroyed(PHLWINDOW window) {
     }
   }
 
-  // Clamp activeWindow to prevent OOB after window removal
-  for (auto &[id, m] : monitors) {
-    if (!m->windows.empty())
-      m->activeWindow = std::min(m->activeWindow, m->windows.size() - 1);
-    else
-      m->activeWindow = 0;
+  // stack may point at an erased monitor, and the idle path would never lay out again
+  stack.clear();
+  scheduleFrame();
+}
+
+// Resident cards follow focus while hidden, so activation finds them already in MRU order
+void Manager::onWindowFocused(PHLWINDOW window) {
+  if (!resident || !window)
+    return;
+  for (auto &[id, mon] : monitors) {
+    mon->promoteWindow(window);
   }
 }
 
+void Manager::onWindowTitle(PHLWINDOW window) {
+  if (!resident || !window)
+    return;
+  for (auto &[id, mon] : monitors) {
+    for (auto &card : mon->windows) {
+      if (card->window == window)
+        card->refreshTitle();
+    }
+  }
+}
+
+// Workspace/monitor change: drop the card and insert it again where it belongs now
+void Manager::onWindowMoved(PHLWINDOW window) {
+  if (!cardsLive() || !window)
+    return;
+  // m_monitor already is the destination here, so look for the card everywhere
+  for (auto it = monitors.begin(); it != monitors.end();) {
+    if (it->second->removeWindow(window) == 0) {
+      it = monitors.erase(it);
+      continue;
+    }
+    ++it;
+  }
+  stack.clear();
+  onWindowCreated(window);
+}
+
 void Manager::onRender(eRenderStage stage) {
-  if (!active)
+  // Nothing is shown during the grace period either, even if prewarm already built cards
+  if (!active || !graceExpired) {
+    // Anything drawn while hidden means the cached background for that workspace is outdated
+    if (stage == eRenderStage::RENDER_BEGIN) {
+      const auto &rd = g_pHyprOpenGL->m_renderData;
+      backgrounds.onFrameDamage(rd.pMonitor.lock(), rd.damage);
+    }
     return;
+  }
 
   const auto FOCUSED_MON = Desktop::focusState()->monitor();
 
   switch (stage) {
   case eRenderStage::RENDER_PRE: {
+    previewFramePending = false;
+    applyMoves();
+    // Animations are sampled for when this output shows the frame, not for now. The render
+    // data isn't set up yet at this stage, the output comes from preRender.
+    const auto RENDERING = renderOutput.lock();
+    const auto OUTPUT = RENDERING ? RENDERING : FOCUSED_MON;
     auto delta = FloatTime(NOW - lastUpdate).count();
-    LOG(Log::DAMAGE, "previousFrameDamage: x1={}, y1={}, x2={}, y2={}", previousFrameDamage.getExtents().x, previousFrameDamage.getExtents().y, previousFrameDamage.getExtents().w, previousFrameDamage.getExtents().h);
-    update(delta);
-    LOG(Log::DAMAGE, "previousFrameDamage: x1={}, y1={}, x2={}, y2={}", previousFrameDamage.getExtents().x, previousFrameDamage.getExtents().y, previousFrameDamage.getExtents().w, previousFrameDamage.getExtents().h);
+    update(delta, predictPresent(OUTPUT), OUTPUT);
     lastUpdate = NOW;
   } break;
 
@@ -406,13 +811,21 @@ void Manager::onRender(eRenderStage stage) {
     if (!monitors.contains(MONITOR->m_id))
       return;
     CRegion damage = rd.damage; // mutable copy — renderSoftwareCursorsFor requires non-const ref
+    // Only the focused output navigates, another output's frame mustn't use up the queue
+    if (!pendingMoves.empty() && MONITOR == FOCUSED_MON)
+      latchMoves(MONITOR, damage);
     renderBackground(rd.pMonitor->m_id, damage);
+    cardBatch.clear();
     if (!Config::splitMonitor)
-      monitors[MONITOR->m_id]->draw(damage, monitorFade.current);
+      monitors[MONITOR->m_id]->draw(cardBatch, damage, monitorFade.current());
     else if (MONITOR == FOCUSED_MON) {
       LOG(Log::DRAW, "Rendering Monitors");
       renderMonitors(damage);
     }
+    if (!cardBatch.empty()) {
+      cardBatch.refreshSnapshots();
+      g_pHyprRenderer->m_renderPass.add(makeUnique<CardBatchPassElement>(&cardBatch));
+    }
 
     // Single deferred flush for the entire frame
     g_pHyprRenderer->m_renderPass.render(damage);
@@ -420,15 +833,27 @@ void Manager::onRender(eRenderStage stage) {
 
 #ifndef NDEBUG
     renderDamage(damage);
-    // Overlay->add(std::format("ActiveID: {}, Offset: {:.2f}", activeMonitor, monitorOffset.current));
+    // Overlay->add(std::format("ActiveID: {}, Offset: {:.2f}", activeMonitor, monitorOffset.current()));
     // Overlay->draw(MONITOR);
 #endif
 
     // stupid cursor..
     g_pPointerManager->renderSoftwareCursorsFor(rd.pMonitor.lock(), Time::steadyNow(), damage);
 
-    if (MONITOR == FOCUSED_MON)
+    if (needsFrame && (MONITOR == FOCUSED_MON || !Config::splitMonitor))
       g_pCompositor->scheduleFrameForMonitor(MONITOR);
+    armPresentTimer();
+  } break;
+
+  case eRenderStage::RENDER_POST: {
+    // Next capture step runs outside of rendering, once this frame is out
+    if (!captureQueue.empty() && !capturePending) {
+      capturePending = true;
+      g_pEventLoopManager->doLater([] {
+        if (manager)
+          manager->pumpCapture();
+      });
+    }
   } break;
 
   default:
@@ -484,21 +909,26 @@ void Manager::onMouseClick(const IPointer::SButtonEvent button) {
           mon->activeWindow = std::distance(mon->windows.begin(), winIt);
           mon->activeChanged();
         }
+        scheduleFrame();
         return;
       }
     }
   }
 }
 
-void Manager::rebuild() {
+void Manager::rebuild(bool captureFocused) {
   LOG_SCOPE()
   if (!active)
     return;
   setLayout();
+  captureQueue.clear();
+  stack.clear();
+  monitors.clear();
+  const auto FOCUSED = Desktop::focusState()->monitor();
   for (const auto &m : g_pCompositor->m_monitors) {
     if (!m->m_enabled || m->m_isUnsafeFallback)
       continue;
-    monitors[m->m_id] = makeUnique<Monitor>(m);
+    addMonitor(m, captureFocused && m == FOCUSED);
   }
   const auto activeWindow = Desktop::focusState()->window();
   const auto history = Desktop::History::windowTracker()->fullHistory();
@@ -508,13 +938,8 @@ void Manager::rebuild() {
     std::vector<PHLWINDOW> monitorWindows;
     for (auto it = history.rbegin(); it != history.rend(); ++it) {
       auto w = it->lock();
-      if (!w)
-        continue;
-      if (!Config::includeSpecial && w->m_workspace && w->m_workspace->m_isSpecialWorkspace)
-        continue;
-      if (w->m_isMapped && (!Config::splitMonitor || w->m_monitor.lock() == mon->monitor)) {
+      if (shouldShow(w, mon->monitor))
         monitorWindows.emplace_back(w);
-      }
     }
     const auto it = std::find_if(monitorWindows.begin(), monitorWindows.end(),
                                  [&](const auto &w) { return w == activeWindow || w == mon->monitor->m_activeWorkspace->m_lastFocusedWindow; });
@@ -523,13 +948,210 @@ void Manager::rebuild() {
       mon->addWindow(w);
     if (!monitorWindows.empty()) {
       mon->activeWindow = activeIdx;
-      mon->windows[activeIdx]->isActive = true;
+      mon->markActive();
       if (activeIdx > 0)
         mon->rotation.snap((M_PI / 2.0f) + ((2.0f * M_PI * activeIdx) / monitorWindows.size()));
     }
   }
 }
 
+// Monitor hotplug tends to come in bursts, fold them into one rebuild once the events are handled
+void Manager::requestRebuild() {
+  dropResident();
+  restartPrewarm();
+  if (!active || !graceExpired || rebuildPending)
+    return;
+  rebuildPending = true;
+  g_pEventLoopManager->doLater([] {
+    if (!manager)
+      return;
+    manager->rebuildPending = false;
+    manager->rebuild();
+    manager->damageMonitors();
+  });
+}
+
+// Activation with resident cards: only the selection, animations and backgrounds are reset
+void Manager::reuseResident() {
+  LOG_SCOPE()
+  captureQueue.clear();
+  const auto FOCUSED = Desktop::focusState()->monitor();
+  activeMonitor = FOCUSED->m_id;
+  monitorOffset.snap(activeMonitor);
+  for (auto &[id, mon] : monitors) {
+    prepareBackground(mon.get(), mon->monitor == FOCUSED);
+    mon->resetState();
+  }
+}
+
+// Cards were built during the grace period, only backgrounds may still be missing
+void Manager::adoptPrewarm() {
+  LOG_SCOPE()
+  captureQueue.clear();
+  const auto FOCUSED = Desktop::focusState()->monitor();
+  activeMonitor = FOCUSED->m_id;
+  monitorOffset.snap(activeMonitor);
+  for (auto &[id, mon] : monitors)
+    prepareBackground(mon.get(), mon->monitor == FOCUSED);
+}
+
+// init() done ahead of time while the grace timer runs: cards from MRU, a first layout,
+// the focused output's background and the titles, one small step per tick. Nothing is
+// drawn before init(), releasing early only drops the cards (backgrounds stay cached).
+void Manager::prewarmStep() {
+  LOG_SCOPE()
+  if (!active || graceExpired)
+    return;
+  const auto FOCUSED = Desktop::focusState()->monitor();
+  if (!FOCUSED)
+    return;
+
+  switch (prewarm) {
+  case Prewarm::CARDS: {
+    if (resident) {
+      captureQueue.clear();
+      for (auto &[id, mon] : monitors)
+        prepareBackground(mon.get(), false);
+    } else
+      rebuild(false);
+    prewarm = Prewarm::LAYOUT;
+  } break;
+
+  case Prewarm::LAYOUT: {
+    // Titles are fitted to the card width, so the cards need a position first. Damage goes nowhere.
+    applyGraceCursor();
+    CRegion scratch;
+    for (auto &[id, mon] : monitors)
+      mon->update(0.0f, 0.0f, scratch);
+    prewarm = Prewarm::BACKGROUND;
+  } break;
+
+  case Prewarm::BACKGROUND: {
+    prewarm = Prewarm::TITLES;
+    const auto it = monitors.find(FOCUSED->m_id);
+    if (it == monitors.end() || it->second->backgroundReady())
+      break;
+    auto &mon = it->second;
+    if (!mon->background->captured()) {
+      mon->captureBackground();
+      // Blur gets its own tick
+      if (mon->background->captured() && !mon->backgroundReady())
+        prewarm = Prewarm::BACKGROUND;
+    } else
+      mon->blurBackground();
+  } break;
+
+  case Prewarm::TITLES: {
+    size_t index = 0, budget = PREWARM_TITLES;
+    for (auto &[id, mon] : monitors)
+      for (auto &card : mon->windows) {
+        if (index++ < prewarmCursor || budget == 0)
+          continue;
+        card->refreshTitle();
+        prewarmCursor++;
+        budget--;
+      }
+    if (budget > 0) {
+      // Upload the new glyphs here rather than in the first frame
+      GlyphAtlas::get(Config::fontSize, FOCUSED->m_scale).texture();
+      prewarm = Prewarm::DONE;
+    }
+  } break;
+
+  default:
+    return;
+  }
+
+  if (prewarm != Prewarm::DONE)
+    prewarmTimer->updateTimeout(PREWARM_STEP);
+}
+
+// Hotplug or config change during the grace period, whatever prewarm built may be wrong
+void Manager::restartPrewarm() {
+  if (!active || graceExpired || prewarm == Prewarm::IDLE)
+    return;
+  if (!resident)
+    monitors.clear();
+  captureQueue.clear();
+  prewarm = Prewarm::CARDS;
+  prewarmCursor = 0;
+  if (prewarmTimer)
+    prewarmTimer->updateTimeout(PREWARM_STEP);
+}
+
+void Manager::dropResident() {
+  if (!resident)
+    return;
+  resident = false;
+  monitors.clear();
+}
+
+bool Manager::cardsLive() const {
+  return (active && (graceExpired || prewarm > Prewarm::CARDS)) || resident;
+}
+
+alttab::Monitor *Manager::addMonitor(PHLMONITOR m, bool captureNow) {
+  auto &mon = monitors[m->m_id] = makeUnique<Monitor>(m);
+  prepareBackground(mon.get(), captureNow);
+  return mon.get();
+}
+
+void Manager::prepareBackground(alttab::Monitor *mon, bool captureNow) {
+  mon->background = backgrounds.get(mon->monitor);
+  if (mon->backgroundReady())
+    return;
+  // Focused output is needed for the first frame, everything else is captured over the following frames
+  if (captureNow) {
+    if (!mon->background->captured())
+      mon->captureBackground();
+    if (Config::blurBG)
+      mon->blurBackground();
+  } else
+    captureQueue.push_back(mon->monitor->m_id);
+}
+
+bool Manager::shouldShow(PHLWINDOW w, PHLMONITOR mon) const {
+  if (!w || !w->m_isMapped)
+    return false;
+  if (!Config::includeSpecial && w->m_workspace && w->m_workspace->m_isSpecialWorkspace)
+    return false;
+  return !Config::splitMonitor || w->m_monitor.lock() == mon;
+}
+
+void Manager::pumpCapture() {
+  LOG_SCOPE()
+  capturePending = false;
+  if (!active) {
+    captureQueue.clear();
+    return;
+  }
+
+  while (!captureQueue.empty()) {
+    auto it = monitors.find(captureQueue.front());
+    if (it == monitors.end()) {
+      captureQueue.pop_front();
+      continue;
+    }
+
+    auto &mon = it->second;
+    if (!mon->background->captured()) {
+      mon->captureBackground();
+      if (!mon->background->captured() || mon->backgroundReady())
+        captureQueue.pop_front();
+    } else {
+      mon->blurBackground();
+      captureQueue.pop_front();
+    }
+
+    if (mon->backgroundReady())
+      g_pHyprRenderer->damageMonitor(mon->monitor);
+    break;
+  }
+
+  if (!captureQueue.empty())
+    scheduleFrame();
+}
+
 bool Manager::isActive() const {
   return active;
 }
@@ -2,6 +2,7 @@
 #include "animvar.hpp"
 #include "monitor.hpp"
 #include "styles.hpp"
+#include <deque>
 #include <map>
 #include <src/SharedDefs.hpp>
 #include <src/helpers/time/Timer.hpp>
@@ -22,10 +23,13 @@ public:
   void toggle();
   void confirm();
   void move(Direction dir);
-  void update(float delta);
-  void rebuild();
+  void update(float delta, Timestamp presentAt, PHLMONITOR output);
+  void rebuild(bool captureFocused = true);
   void draw(MONITORID monid, const CRegion &damage);
   void damageMonitors();
+  void scheduleFrame();
+  void damagePreview(const WindowCard *card);
+  void invalidateBackground(PHLWINDOW window);
   bool isActive() const;
 
 protected:
@@ -36,6 +40,9 @@ private:
   void onConfigReload();
   void onWindowCreated(PHLWINDOW window);
   void onWindowDestroyed(PHLWINDOW window);
+  void onWindowFocused(PHLWINDOW window);
+  void onWindowTitle(PHLWINDOW window);
+  void onWindowMoved(PHLWINDOW window);
   void onRender(eRenderStage stage);
   void onFocusChange(PHLMONITOR monitor);
   void onMouseClick(const IPointer::SButtonEvent button);
@@ -50,13 +57,36 @@ private:
   void renderDamage(const CRegion &damage);
 
   bool setLayout();
+  void cycleGrace(Direction dir);
+  void applyMoves(std::vector<WindowCard *> *affected = nullptr);
+  void latchMoves(PHLMONITOR output, CRegion &damage);
+  alttab::Monitor *step(Direction dir);
+  void applyGraceCursor();
+  void requestRebuild();
+  void reuseResident();
+  void adoptPrewarm();
+  void prewarmStep();
+  void restartPrewarm();
+  void dropResident();
+  bool cardsLive() const;
+  alttab::Monitor *addMonitor(PHLMONITOR monitor, bool captureNow);
+  void prepareBackground(alttab::Monitor *mon, bool captureNow);
+  bool shouldShow(PHLWINDOW window, PHLMONITOR monitor) const;
+  void pumpCapture();
+  void armPresentTimer();
+  Timestamp predictPresent(PHLMONITOR output) const;
+  void presentThrottled();
 
 #ifdef HYPRLAND_LEGACY
   struct {
     SP<HOOK_CALLBACK_FN> config;
     SP<HOOK_CALLBACK_FN> windowCreated;
     SP<HOOK_CALLBACK_FN> windowDestroyed;
+    SP<HOOK_CALLBACK_FN> windowFocused;
+    SP<HOOK_CALLBACK_FN> windowTitle;
+    SP<HOOK_CALLBACK_FN> windowMoved;
     SP<HOOK_CALLBACK_FN> render;
+    SP<HOOK_CALLBACK_FN> preRender;
     SP<HOOK_CALLBACK_FN> focusChange;
     SP<HOOK_CALLBACK_FN> monitorAdded;
     SP<HOOK_CALLBACK_FN> monitorRemoved;
@@ -66,7 +96,11 @@ private:
     CHyprSignalListener config;
     CHyprSignalListener windowCreated;
     CHyprSignalListener windowDestroyed;
+    CHyprSignalListener windowFocused;
+    CHyprSignalListener windowTitle;
+    CHyprSignalListener windowMoved;
     CHyprSignalListener render;
+    CHyprSignalListener preRender;
     CHyprSignalListener focusChange;
     CHyprSignalListener monitorAdded;
     CHyprSignalListener monitorRemoved;
@@ -77,6 +111,10 @@ private:
 
   SP<CEventLoopTimer> loopTimer;
   SP<CEventLoopTimer> graceTimer;
+  // Steps init()'s work while the grace timer is pending, see prewarmStep()
+  SP<CEventLoopTimer> prewarmTimer;
+  // Wakes up throttled previews between frames, see WindowCard::presentInterval
+  SP<CEventLoopTimer> presentTimer;
 
   Timestamp lastFrame;
   std::map<MONITORID, UP<alttab::Monitor>> monitors;
@@ -85,9 +123,42 @@ private:
   Timestamp lastUpdate;
   SP<IStyle> layoutStyle;
   bool graceExpired = false;
+  enum class Prewarm : uint8_t {
+    IDLE,
+    CARDS,
+    LAYOUT,
+    BACKGROUND,
+    TITLES,
+    DONE,
+  };
+  // Cards exist once this is past CARDS, even though nothing is drawn before init()
+  Prewarm prewarm = Prewarm::IDLE;
+  size_t prewarmCursor = 0;
+  // MRU snapshot and cursor for cycling before the grace timer fires
+  std::vector<PHLWINDOWREF> mru;
+  size_t mruCursor = 1;
+  // Navigation since the last frame, see move()
+  std::vector<Direction> pendingMoves;
   std::vector<MonitorElement> stack;
-  CRegion previousFrameDamage;
+  // Card damage of the last frames, per output that showed cards
+  std::map<MONITORID, DamageRing> damageHistory;
+  // Output of the frame being built, from preRender. RENDER_PRE doesn't say which one it is.
+  PHLMONITORREF renderOutput;
   bool wasAnimating = true;
+  // Set by update() while something is in flight, consumed in RENDER_LAST_MOMENT
+  bool needsFrame = false;
+  // A commit already asked for the next frame, later commits only add damage
+  bool previewFramePending = false;
+  // Outputs still waiting for their background, one capture/blur step per frame
+  std::deque<MONITORID> captureQueue;
+  bool capturePending = false;
+  bool rebuildPending = false;
+  // Cards and monitors were kept alive by deactivate() and are updated while hidden (Config::resident)
+  bool resident = false;
+  // Survives deactivate(), so an unchanged workspace is never captured twice
+  BackgroundCache backgrounds;
+  // Card draw records for the frame being rendered, capacity is kept between frames
+  CardBatch cardBatch;
 
   friend class alttab::Monitor;
 };
@@ -23,10 +23,9 @@
 using namespace alttab;
 
 alttab::Monitor::Monitor(PHLMONITOR monitor) : monitor(monitor),
-                                               alpha(&Config::monitorAnimationSpeed),
-                                               rotation(&Config::rotationSpeed),
-                                               zoom(&Config::monitorAnimationSpeed) {
-  createTexture();
+                                               alpha(&Config::monitorAnimationSpeed, &Curves::monitor),
+                                               rotation(&Config::rotationSpeed, &Curves::rotation),
+                                               zoom(&Config::monitorAnimationSpeed, &Curves::monitor) {
   rotation.snap(M_PI / 2.0f);
   if (isActive()) {
     zoom.snap(1.0f);
@@ -36,63 +35,87 @@ alttab::Monitor::Monitor(PHLMONITOR monitor) : monitor(monitor),
     alpha.snap(0.1f);
   }
 }
-void alttab::Monitor::createTexture() {
-  LOG_SCOPE()
-  bgFb = makeShared<CFramebuffer>();
-  blurFb = makeShared<CFramebuffer>();
-  if (monitor->m_pixelSize.x <= 0 || monitor->m_pixelSize.y <= 0)
-    return;
+void alttab::Monitor::captureBackground() {
+  if (background)
+    background->capture(monitor);
+}
 
-  if (!bgFb->isAllocated() || bgFb->m_size != monitor->m_pixelSize)
-    bgFb->alloc(monitor->m_pixelSize.x, monitor->m_pixelSize.y, monitor->m_drmFormat);
-  CRegion fullRegion = CBox({0, 0}, monitor->m_pixelSize);
-
-  OVERRIDE_WORKSPACE = false;
-  g_pHyprRenderer->beginRender(monitor, fullRegion, RENDER_MODE_FULL_FAKE, {}, bgFb.get());
-  g_pHyprRenderer->renderWorkspace(monitor, monitor->m_activeWorkspace, Time::steadyNow(), fullRegion.getExtents());
-  g_pHyprRenderer->m_renderPass.render(fullRegion);
-  g_pHyprRenderer->m_renderPass.clear();
-  g_pHyprRenderer->endRender();
-  OVERRIDE_WORKSPACE = true;
-  texture = bgFb->getTexture();
-
-  if (!blurFb->isAllocated() || blurFb->m_size != monitor->m_pixelSize / 2)
-    blurFb->alloc(monitor->m_pixelSize.x / 2, monitor->m_pixelSize.y / 2, monitor->m_drmFormat);
-  CRegion blurRegion = CBox({0, 0}, monitor->m_pixelSize);
-
-  g_pHyprRenderer->beginRender(monitor, blurRegion, RENDER_MODE_FULL_FAKE, {}, blurFb.get());
-
-  CBox destBox = {{0, 0}, monitor->m_pixelSize / 2};
-  CTexPassElement::SRenderData data;
-  data.tex = texture;
-  data.box = destBox;
-  data.blur = true;
-  g_pHyprRenderer->m_renderPass.add(makeUnique<CTexPassElement>(data));
-
-  // Blur trigger — deferred via CRectPassElement
-  {
-    CRectPassElement::SRectData rect;
-    rect.box = destBox;
-    rect.color = {0.0, 0.0, 0.0, 0.0};
-    rect.blur = true;
-    g_pHyprRenderer->m_renderPass.add(makeUnique<CRectPassElement>(rect));
-  }
+void alttab::Monitor::blurBackground() {
+  if (background)
+    background->blur(monitor);
+}
 
-  g_pHyprRenderer->m_renderPass.render(blurRegion);
-  g_pHyprRenderer->m_renderPass.clear();
-  g_pHyprRenderer->endRender();
-  blurred = blurFb->getTexture();
+bool alttab::Monitor::backgroundReady() const {
+  return background && background->ready();
 }
 
 WP<WindowCard> alttab::Monitor::addWindow(PHLWINDOW window) {
   auto w = makeUnique<WindowCard>(window);
+  w->output = monitor;
   windows.emplace_back(std::move(w));
   return windows.back();
 }
+void alttab::Monitor::insertWindow(PHLWINDOW window, size_t index) {
+  LOG_SCOPE()
+  if (std::ranges::any_of(windows, [&](const auto &card) { return card->window == window; }))
+    return;
+
+  index = std::min(index, windows.size());
+  auto card = makeUnique<WindowCard>(window);
+  card->output = monitor;
+  windows.insert(windows.begin() + index, std::move(card));
+
+  // Keep the same card selected, it just moved one slot down
+  if (windows.size() > 1 && index <= activeWindow)
+    activeWindow++;
+  else if (windows.size() == 1)
+    activeWindow = 0;
+
+  // Count changed, so the rotation target moves too
+  activeChanged();
+}
+
+void alttab::Monitor::promoteWindow(PHLWINDOW window) {
+  auto it = std::find_if(windows.begin(), windows.end(), [&](const auto &card) { return card->window == window; });
+  if (it == windows.end() || it == windows.begin())
+    return;
+  std::rotate(windows.begin(), it, it + 1);
+}
+
+// Same state a freshly built monitor starts with, without touching every card
+void alttab::Monitor::resetState() {
+  activeWindow = 0;
+  pendingSteps = 0;
+  markActive();
+
+  rotation.snap(M_PI / 2.0f);
+  zoom.snap(isActive() ? 1.0f : 0.1f);
+  alpha.snap(isActive() ? 1.0f : 0.1f);
+}
+
 size_t alttab::Monitor::removeWindow(PHLWINDOW window) {
-  std::erase_if(windows, [&](const auto &card) {
-    return card->window == window;
-  });
+  // Layout results hold raw card pointers and outlive the card while idle, the present timer walks them
+  std::erase_if(renderTasks, [&](const auto &task) { return task.card && task.card->window == window; });
+  batchCards.clear();
+  const auto it = std::ranges::find_if(windows, [&](const auto &card) { return card->window == window; });
+  if (it == windows.end())
+    return windows.size();
+
+  const auto &card = *it;
+  // Damage only follows cards that are still laid out, so clear where this one was
+  const auto OUTPUT = Config::splitMonitor ? Desktop::focusState()->monitor() : card->output.lock();
+  if (OUTPUT && !card->lastBox.empty())
+    manager->damageHistory[OUTPUT->m_id].pending.add(card->lastBox.copy().translate(OUTPUT->m_position));
+  if (card.get() == activeCard)
+    activeCard = nullptr;
+
+  // Keep the selection on the same card, or on its successor if it was this one
+  const size_t index = it - windows.begin();
+  windows.erase(it);
+  if (index < activeWindow)
+    activeWindow--;
+  activeWindow = windows.empty() ? 0 : std::min(activeWindow, windows.size() - 1);
+  activeChanged();
   return windows.size();
 }
 
@@ -119,87 +142,138 @@ void alttab::Monitor::update(const float delta, const float offset, CRegion &dam
       .midpoint = MONITOR->m_size * 0.5f,
       .radius = r,
       .tiltOffset = r * std::sin(Config::tilt * ((float)M_PI / 180.0f)),
-      .rotation = rotation.current,
-      .scale = zoom.current,
-      .alpha = alpha.current,
-      .activeProgress = std::clamp(rotation.progress, 0.0f, 1.0f)};
+      .rotation = rotation.current(),
+      .scale = zoom.current(),
+      .alpha = alpha.current(),
+      .activeProgress = std::clamp(rotation.progress(), 0.0f, 1.0f)};
 
   const size_t winCount = windows.size();
   renderTasks.clear();
   if (winCount > renderTasks.capacity())
     renderTasks.reserve(winCount);
 
+  batchCards.clear();
+  batch.resize(winCount);
   for (size_t i = 0; i < winCount; ++i) {
     //Guard against expired window handles
     if (!windows[i] || !windows[i]->window || !windows[i]->window->wlSurface())
       continue;
 
-    RenderData data = manager->layoutStyle->calculate(ctx, windows[i]->window->m_size, i);
-    if (!data.visible)
+    const size_t slot = batchCards.size();
+    batch.width[slot] = windows[i]->window->m_size.x;
+    batch.height[slot] = windows[i]->window->m_size.y;
+    batch.index[slot] = (float)i;
+    batchCards.push_back(windows[i].get());
+  }
+  batch.count = batchCards.size();
+
+  manager->layoutStyle->calculateBatch(ctx, batch);
+
+  damageRects.clear();
+  for (size_t slot = 0; slot < batch.count; ++slot) {
+    if (batch.visible[slot] == 0.0f) {
+      // Dropped out of the layout, still has to be cleared where it was
+      damageRects.add(batchCards[slot]->lastBox);
+      batchCards[slot]->lastBox = {};
+      batchCards[slot]->previewVisible = false;
+      batchCards[slot]->presentInterval = -1.0f;
       continue;
+    }
 
+    RenderData data = batch.get(slot);
     data.position.translate({0, (int)offset}).round();
-    windows[i]->setPosition(data.position);
+    batchCards[slot]->setPosition(data.position);
 
-    renderTasks.emplace_back(RenderTask{windows[i].get(), data, 0.0f});
+    renderTasks.emplace_back(RenderTask{batchCards[slot], data, 0.0f});
   }
 
   std::stable_sort(renderTasks.begin(), renderTasks.end(), [](const auto &a, const auto &b) {
     return a.data.z > b.data.z;
   });
 
-  //Unified bounding-box damage instead of per-card expansion
-  CRegion usedArea;
-  double minX = 1e9, minY = 1e9, maxX = -1e9, maxY = -1e9;
-
-  for (auto &task : renderTasks) {
-    CRegion visible = CRegion(task.data.position).subtract(usedArea);
-    if (visible.empty()) {
-      task.visibility = 0.0f;
-      continue;
+  // Front to back through a coverage bitmask, see OcclusionGrid
+  if (!renderTasks.empty()) {
+    double gx1 = 1e9, gy1 = 1e9, gx2 = -1e9, gy2 = -1e9;
+    for (const auto &task : renderTasks) {
+      gx1 = std::min(gx1, task.data.position.x);
+      gy1 = std::min(gy1, task.data.position.y);
+      gx2 = std::max(gx2, task.data.position.x + task.data.position.width);
+      gy2 = std::max(gy2, task.data.position.y + task.data.position.height);
     }
+    occlusion.reset({gx1, gy1, gx2 - gx1, gy2 - gy1});
+  }
 
-    double area = 0;
-    visible.forEachRect([&area](const pixman_box32_t &r) {
-      area += (double)(r.x2 - r.x1) * (r.y2 - r.y1);
-    });
-
-    task.visibility = std::clamp((float)(area / (task.data.position.width * task.data.position.height)), 0.0f, 1.0f);
-
-    // Accumulate this window's footprint into the occlusion mask for subsequent (background) windows
-    usedArea.add(task.data.position);
+  // Where each card was and where it is now, merged into a few rects
+  for (auto &task : renderTasks) {
+    task.visibility = std::clamp(occlusion.cover(task.data.position), 0.0f, 1.0f);
+    task.card->previewVisible = task.visibility > 0.0f;
+    task.card->presentInterval = presentBudget(task, MONITOR->m_size);
 
-    // Accumulate global bounds (padded for blur kernel headroom)
     CBox outerBox = task.data.position.copy();
     outerBox.round();
-    outerBox.expand(Config::borderSize + 32);
-    minX = std::min(minX, outerBox.x);
-    minY = std::min(minY, outerBox.y);
-    maxX = std::max(maxX, outerBox.x + outerBox.width);
-    maxY = std::max(maxY, outerBox.y + outerBox.height);
+    outerBox.expand(Config::borderSize + 2);
+    damageRects.add(task.card->lastBox);
+    damageRects.add(outerBox);
+    task.card->lastBox = outerBox;
   }
 
-  // Submit a single unified damage rectangle
-  if (minX < maxX && minY < maxY) {
-    cachedGlobalBounds = CBox{minX, minY, maxX - minX, maxY - minY};
-    cachedGlobalBounds.round();
-    damage.add(cachedGlobalBounds);
-  }
+  cachedDamage.clear();
+  damageRects.addTo(cachedDamage);
+  damage.add(cachedDamage);
 }
 
-void alttab::Monitor::draw(const CRegion &damage, const float alpha) {
+void alttab::Monitor::draw(CardBatch &cards, const CRegion &damage, const float alpha) {
   LOG_SCOPE(Log::DRAW)
+  const auto MONITOR = Desktop::focusState()->monitor();
+  const float scale = MONITOR->m_scale;
+
+  // Front to back: each card only gets the damage not already covered by opaque cards in front of it.
+  // Only the preview area is solid, and only for cards that aren't faded.
+  CRegion opaque;
+  for (auto &task : renderTasks) {
+    task.clip.clear();
+    if (!task.card || !task.card->window)
+      continue;
+
+    const auto layout = task.card->buildLayout(scale);
+    task.clip = damage.copy().intersect(layout.outer).subtract(opaque);
+    if (task.clip.empty())
+      continue;
+
+    if (task.data.alpha * alpha >= 1.0f) {
+      CBox solid = layout.preview.copy().expand(-Config::borderRounding);
+      if (solid.width > 0 && solid.height > 0)
+        opaque.add(solid);
+    }
+  }
 
+  const auto now = NOW;
   for (auto &task : renderTasks | std::views::reverse) {
     // Guard card and window validity
     if (!task.card || !task.card->window)
       continue;
-    task.card->draw(damage);
-    if (Config::livePreview && task.visibility > Config::previewCutoff)
-      task.card->present();
+    if (!task.clip.empty())
+      task.card->draw(cards, std::clamp(task.data.alpha * alpha, 0.0f, 1.0f), task.clip);
+    // Frame callbacks keep going even when nothing of the card was redrawn, or the client stops committing
+    if (Config::livePreview)
+      task.card->presentIfDue(now);
   }
 }
 
+// How often a card's client gets frame callbacks: the selected card at full rate, big
+// previews at preview_rate_mid, the small ones further back at preview_rate_back
+float alttab::Monitor::presentBudget(const RenderTask &task, const Vector2D &outputSize) const {
+  if (task.visibility <= Config::previewCutoff)
+    return -1.0f;
+  if (task.card->isActive && isActive())
+    return 0.0f;
+
+  const double visibleArea = task.visibility * task.data.position.width * task.data.position.height;
+  const bool large = visibleArea >= outputSize.x * outputSize.y * 0.05;
+  const float rate = large ? Config::previewRateMid : Config::previewRateBack;
+  return rate > 0.0f ? 1.0f / rate : -1.0f;
+}
+
 void alttab::Monitor::activeChanged() {
   LOG_SCOPE()
   const int count = windows.size();
@@ -208,18 +282,32 @@ void alttab::Monitor::activeChanged() {
     return;
   }
 
-  LOG(Log::UPDATE, "activeWindow1: {}, size: {}", activeWindow, count);
+  LOG(Log::UPDATE, "activeWindow: {}, size: {}, steps: {}", activeWindow, count, pendingSteps);
+  markActive();
 
-  for (auto i = 0; i < windows.size(); ++i) {
-    windows[i]->isActive = (i == activeWindow);
-  }
-  LOG(Log::UPDATE, "activeWindow2: {}, size: {}", activeWindow, count);
   // Why am i doing this backwards?? stilling figuring out
-  const auto target = (M_PI / 2) + (M_PI * 2.0f * activeWindow) / count;
-  auto diff = target - rotation.target;
-  diff = std::remainder(diff, 2.0f * M_PI);
+  double diff;
+  if (pendingSteps != 0) {
+    // Several queued steps may add up to more than half a turn, keep the direction they went
+    diff = (M_PI * 2.0f * pendingSteps) / count;
+    pendingSteps = 0;
+  } else {
+    const auto target = (M_PI / 2) + (M_PI * 2.0f * activeWindow) / count;
+    diff = std::remainder(target - rotation.target(), 2.0f * M_PI);
+  }
 
-  rotation.set(rotation.target + diff, false);
+  rotation.set(rotation.target() + diff, false);
+}
+
+void alttab::Monitor::markActive() {
+  WindowCard *card = activeWindow < windows.size() ? windows[activeWindow].get() : nullptr;
+  if (card == activeCard)
+    return;
+  if (activeCard)
+    activeCard->isActive = false;
+  activeCard = card;
+  if (activeCard)
+    activeCard->isActive = true;
 }
 
 bool alttab::Monitor::isActive() const {
@@ -1,6 +1,10 @@
 #pragma once
 #include "animvar.hpp"
+#include "background.hpp"
+#include "cardbatch.hpp"
 #include "container.hpp"
+#include "damage.hpp"
+#include "occlusion.hpp"
 #include "styles.hpp"
 #include <src/desktop/state/FocusState.hpp>
 #include <src/desktop/view/Window.hpp>
@@ -15,19 +19,36 @@ private:
     WindowCard *card;
     RenderData data;
     float visibility = 0.0f;
+    // Part of the frame damage this card may touch, empty when culled
+    CRegion clip;
   };
 
+  float presentBudget(const RenderTask &task, const Vector2D &outputSize) const;
+
 protected:
   std::vector<RenderTask> renderTasks;
+  // Reused between frames so layout doesn't allocate
+  StyleBatch batch;
+  std::vector<WindowCard *> batchCards;
+  OcclusionGrid occlusion;
+  DamageAccumulator damageRects;
 
 public:
   Monitor(PHLMONITOR monitor);
-  void createTexture();
+  // Background capture is staged: capture first, blur on a later frame. See Manager::pumpCapture.
+  void captureBackground();
+  void blurBackground();
+  bool backgroundReady() const;
   WP<WindowCard> addWindow(PHLWINDOW window);
+  void insertWindow(PHLWINDOW window, size_t index);
+  void promoteWindow(PHLWINDOW window);
+  void resetState();
+  // Cards left afterwards. The selection stays on the same card, or moves to the next one.
   size_t removeWindow(PHLWINDOW window);
   void update(const float delta, const float offset, CRegion &damage);
-  void draw(const CRegion &damage, const float alpha);
+  void draw(CardBatch &cards, const CRegion &damage, const float alpha);
   void activeChanged();
+  void markActive();
   bool isActive() const;
 
   CBox position;
@@ -35,14 +56,16 @@ public:
   AnimatedValue<float> zoom;
   AnimatedValue<float> alpha;
   PHLMONITOR monitor;
-  SP<CTexture> texture;
-  SP<CTexture> blurred;
-  SP<CFramebuffer> bgFb, blurFb;
+  SP<Background> background;
   size_t activeWindow = 0;
   std::vector<UP<WindowCard>> windows;
+  // Card currently flagged isActive, so a selection change touches two cards, not all of them
+  WindowCard *activeCard = nullptr;
+  // Signed slots moved since the last activeChanged(), so coalesced steps keep their direction
+  int pendingSteps = 0;
 
-  // changed something here now forgotten
-  CBox cachedGlobalBounds;
+  // Damage of the last animated frame, monitor local
+  CRegion cachedDamage;
 
   friend class Manager;
 };
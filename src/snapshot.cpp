@@ -0,0 +1,180 @@
+#include "snapshot.hpp"
+#include "cardbatch.hpp"
+#include "cardshader.hpp"
+#include "logger.hpp"
+#include <drm_fourcc.h>
+#include <hyprutils/math/Vector2D.hpp>
+
+#define private public
+#define protected public
+#include <src/render/OpenGL.hpp>
+#undef protected
+#undef private
+
+using namespace alttab;
+
+static const char *BLIT_VERT = R"#(#version 300 es
+uniform vec4 dst;
+uniform vec2 target;
+in vec2 pos;
+out vec2 v_uv;
+
+void main() {
+  vec2 p = (dst.xy + pos * dst.zw) / target;
+  gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
+  v_uv = pos;
+}
+)#";
+
+static const char *BLIT_FRAG = R"#(#version 300 es
+precision highp float;
+in vec2 v_uv;
+uniform sampler2D tex;
+uniform int opaqueTex;
+out vec4 fragColor;
+
+void main() {
+  vec4 c = texture(tex, v_uv);
+  if (opaqueTex == 1)
+    c.a = 1.0;
+  fragColor = c;
+}
+)#";
+
+namespace {
+struct BlitProgram {
+  GLuint program = 0;
+  GLuint vao = 0;
+  GLuint vbo = 0;
+  // Linear filtering without touching the parameters of the client's textures
+  GLuint sampler = 0;
+  GLint dst = -1;
+  GLint target = -1;
+  GLint tex = -1;
+  GLint opaqueTex = -1;
+  bool failed = false;
+};
+BlitProgram blit;
+
+bool ensureBlit() {
+  if (blit.program)
+    return true;
+  if (blit.failed)
+    return false;
+
+  blit.program = compileProgram(BLIT_VERT, BLIT_FRAG);
+  if (!blit.program) {
+    blit.failed = true;
+    return false;
+  }
+  blit.dst = glGetUniformLocation(blit.program, "dst");
+  blit.target = glGetUniformLocation(blit.program, "target");
+  blit.tex = glGetUniformLocation(blit.program, "tex");
+  blit.opaqueTex = glGetUniformLocation(blit.program, "opaqueTex");
+  blit.vao = createUnitQuad(blit.vbo);
+
+  glGenSamplers(1, &blit.sampler);
+  glSamplerParameteri(blit.sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glSamplerParameteri(blit.sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glSamplerParameteri(blit.sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glSamplerParameteri(blit.sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  return true;
+}
+} // namespace
+
+void CardSnapshot::invalidate() {
+  dirty = true;
+}
+
+bool CardSnapshot::needsRefresh(const Vector2D &size) const {
+  if (dirty || !ready())
+    return true;
+  // Mips cover shrinking, but a card that grew past its snapshot would get blurry
+  return size.x > rendered.x * 1.1 || size.y > rendered.y * 1.1 || size.x < rendered.x * 0.5 || size.y < rendered.y * 0.5;
+}
+
+bool CardSnapshot::ready() const {
+  return fb && fb->isAllocated() && rendered.x > 0 && rendered.y > 0;
+}
+
+SP<CTexture> CardSnapshot::texture() const {
+  return fb ? fb->getTexture() : nullptr;
+}
+
+Vector2D CardSnapshot::uvScale() const {
+  if (allocated.x <= 0 || allocated.y <= 0)
+    return {1, 1};
+  return {rendered.x / allocated.x, rendered.y / allocated.y};
+}
+
+bool CardSnapshot::refresh(const Vector2D &size, std::span<const CardSurface> surfaces, const Vector2D &origin, const GLTarget &restore) {
+  LOG_SCOPE(Log::SNAPSHOT)
+  if (size.x < 1 || size.y < 1 || surfaces.empty())
+    return false;
+  // The blit samples sampler2D only, external textures stay on the direct path
+  for (const auto &surface : surfaces)
+    if (!CardShader::canSample(surface.tex))
+      return false;
+  if (!ensureBlit())
+    return false;
+
+  const Vector2D want = {std::ceil(size.x), std::ceil(size.y)};
+  if (!fb || want.x > allocated.x || want.y > allocated.y || want.x * want.y * 4 < allocated.x * allocated.y) {
+    // Some headroom so a card growing during an animation doesn't reallocate every frame
+    allocated = {std::ceil(want.x * 1.25), std::ceil(want.y * 1.25)};
+    if (!fb)
+      fb = makeShared<CFramebuffer>();
+    fb->alloc(allocated.x, allocated.y, DRM_FORMAT_ABGR8888);
+    LOG(Log::SNAPSHOT, "snapshot realloc {}x{}", allocated.x, allocated.y);
+  }
+
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fb->getFBID());
+  glViewport(0, 0, allocated.x, allocated.y);
+  g_pHyprOpenGL->scissor(nullptr);
+  glClearColor(0, 0, 0, 0);
+  glClear(GL_COLOR_BUFFER_BIT);
+
+  g_pHyprOpenGL->blend(true);
+  g_pHyprOpenGL->useProgram(blit.program);
+  glUniform2f(blit.target, allocated.x, allocated.y);
+  glUniform1i(blit.tex, 0);
+  glActiveTexture(GL_TEXTURE0);
+  glBindSampler(0, blit.sampler);
+  glBindVertexArray(blit.vao);
+
+  // Main surface first, subsurfaces on top at their offsets
+  for (const auto &surface : surfaces) {
+    const CBox box = surface.box.copy().translate(Vector2D{-origin.x, -origin.y});
+    glBindTexture(surface.tex->m_target, surface.tex->m_texID);
+    glUniform4f(blit.dst, box.x, box.y, box.w, box.h);
+    glUniform1i(blit.opaqueTex, surface.tex->m_type == TEXTURE_RGBX);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindTexture(surface.tex->m_target, 0);
+  }
+  glBindVertexArray(0);
+  glBindSampler(0, 0);
+
+  const auto tex = fb->getTexture();
+  glBindTexture(GL_TEXTURE_2D, tex->m_texID);
+  glGenerateMipmap(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, restore.fb);
+  glViewport(0, 0, restore.viewport.x, restore.viewport.y);
+
+  rendered = want;
+  dirty = false;
+  return true;
+}
+
+void CardSnapshot::destroy() {
+  if (blit.vbo)
+    glDeleteBuffers(1, &blit.vbo);
+  if (blit.vao)
+    glDeleteVertexArrays(1, &blit.vao);
+  if (blit.program)
+    glDeleteProgram(blit.program);
+  if (blit.sampler)
+    glDeleteSamplers(1, &blit.sampler);
+  blit = {};
+}
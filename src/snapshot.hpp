@@ -0,0 +1,41 @@
+#pragma once
+#include "defines.hpp"
+#include <GLES3/gl32.h>
+#include <span>
+#include <src/render/Framebuffer.hpp>
+
+namespace alttab {
+
+struct CardSurface;
+
+// What a refresh binds back afterwards, so it never has to read the state from GL
+struct GLTarget {
+  GLuint fb = 0;
+  Vector2D viewport;
+};
+
+// Card-sized copy of a window with its subsurfaces, mipmapped so a shrinking card doesn't
+// alias. Cards sample this instead of the client buffer, so the cost follows the card
+// size, not the client's. Re-rendered on commit, or when the card outgrows it.
+class CardSnapshot {
+public:
+  void invalidate();
+  bool needsRefresh(const Vector2D &size) const;
+  // Surface boxes are relative to the snapshot's top-left, in pixels. Call before the render
+  // pass, it binds its own framebuffer and puts restore back when done.
+  bool refresh(const Vector2D &size, std::span<const CardSurface> surfaces, const Vector2D &origin, const GLTarget &restore);
+  bool ready() const;
+  SP<CTexture> texture() const;
+  // Part of the texture the last refresh filled
+  Vector2D uvScale() const;
+
+  static void destroy();
+
+private:
+  SP<CFramebuffer> fb;
+  Vector2D allocated;
+  Vector2D rendered;
+  bool dirty = true;
+};
+
+} // namespace alttab
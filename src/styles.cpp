@@ -1,11 +1,28 @@
 #include "styles.hpp"
 #include "defines.hpp"
+#include "helpers.hpp"
 #include "logger.hpp"
 #include <hyprutils/math/Vector2D.hpp>
 #include <src/desktop/state/FocusState.hpp>
 #include <src/helpers/Monitor.hpp>
 #include <xmmintrin.h>
 
+void IStyle::calculateBatch(const StyleContext &ctx, StyleBatch &batch) const {
+  for (size_t i = 0; i < batch.count; ++i) {
+    const auto data = calculate(ctx, {batch.width[i], batch.height[i]}, (size_t)batch.index[i]);
+    batch.visible[i] = data.visible ? 1.0f : 0.0f;
+    if (!data.visible)
+      continue;
+    batch.x[i] = data.position.x;
+    batch.y[i] = data.position.y;
+    batch.w[i] = data.position.width;
+    batch.h[i] = data.position.height;
+    batch.z[i] = data.z;
+    batch.scale[i] = data.scale;
+    batch.alpha[i] = data.alpha;
+  }
+}
+
 RenderData Carousel::calculate(const StyleContext &ctx, const Vector2D &surfaceSize, const size_t index) const {
   const float angle = ctx.rotation - (ctx.angleStep * index);
 
@@ -47,6 +64,52 @@ RenderData Carousel::calculate(const StyleContext &ctx, const Vector2D &surfaceS
       .position = {pos, size}};
 }
 
+void Carousel::calculateBatch(const StyleContext &ctx, StyleBatch &batch) const {
+  const float wSize = Config::CWSize.value_or(Config::windowSize);
+  const float activeSize = Config::CWSizeActive.value_or(Config::windowSizeActive);
+  const float inactiveSize = Config::CWSizeInactive.value_or(Config::windowSizeInactive);
+
+  const __m128 ONE = _mm_set1_ps(1.0f);
+  const __m128 HALF = _mm_set1_ps(0.5f);
+  const __m128 ROTATION = _mm_set1_ps(ctx.rotation);
+  const __m128 STEP = _mm_set1_ps(ctx.angleStep);
+  const __m128 ALPHA = _mm_set1_ps(ctx.alpha);
+  const __m128 INACTIVE = _mm_set1_ps(inactiveSize);
+  const __m128 INACTIVE_RANGE = _mm_set1_ps(1.0f - inactiveSize);
+  const __m128 BOOST = _mm_set1_ps((activeSize - 1.0f) * 2.0f * ctx.scale);
+  const __m128 BASE_H = _mm_set1_ps(ctx.mSize.y * wSize);
+  const __m128 RADIUS = _mm_set1_ps(ctx.radius * 1.4f);
+  const __m128 MID_X = _mm_set1_ps(ctx.midpoint.x);
+  const __m128 MID_Y = _mm_set1_ps(ctx.midpoint.y - ctx.tiltOffset);
+  const __m128 TILT = _mm_set1_ps(ctx.tiltOffset);
+
+  for (size_t i = 0; i < batch.count; i += 4) {
+    const __m128 angle = _mm_sub_ps(ROTATION, _mm_mul_ps(STEP, _mm_loadu_ps(&batch.index[i])));
+    __m128 z, c;
+    fast_sincos_ps(angle, z, c);
+
+    const __m128 zNorm = _mm_mul_ps(_mm_add_ps(z, ONE), HALF);
+    const __m128 finalAlpha = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(zNorm, _mm_set1_ps(0.8f)), _mm_set1_ps(0.2f)), ALPHA);
+
+    __m128 scale = _mm_add_ps(INACTIVE, _mm_mul_ps(INACTIVE_RANGE, zNorm));
+    const __m128 boosted = _mm_mul_ps(scale, _mm_add_ps(ONE, _mm_mul_ps(BOOST, _mm_sub_ps(z, HALF))));
+    scale = select_ps(_mm_cmpgt_ps(z, HALF), boosted, scale);
+
+    const __m128 aspect = _mm_div_ps(_mm_loadu_ps(&batch.width[i]), _mm_max_ps(_mm_loadu_ps(&batch.height[i]), ONE));
+    const __m128 h = _mm_mul_ps(BASE_H, scale);
+    const __m128 w = _mm_mul_ps(h, aspect);
+
+    _mm_storeu_ps(&batch.x[i], _mm_sub_ps(_mm_add_ps(MID_X, _mm_mul_ps(RADIUS, c)), _mm_mul_ps(w, HALF)));
+    _mm_storeu_ps(&batch.y[i], _mm_sub_ps(_mm_add_ps(MID_Y, _mm_mul_ps(z, TILT)), _mm_mul_ps(h, HALF)));
+    _mm_storeu_ps(&batch.w[i], w);
+    _mm_storeu_ps(&batch.h[i], h);
+    _mm_storeu_ps(&batch.z[i], z);
+    _mm_storeu_ps(&batch.scale[i], scale);
+    _mm_storeu_ps(&batch.alpha[i], _mm_min_ps(finalAlpha, ONE));
+    _mm_storeu_ps(&batch.visible[i], _mm_and_ps(_mm_cmpge_ps(finalAlpha, _mm_set1_ps(0.01f)), ONE));
+  }
+}
+
 MoveResult Carousel::onMove(Direction dir, const size_t index, const size_t count) {
   if (dir == Direction::UP || dir == Direction::DOWN)
     return {.changeMonitor = true};
@@ -120,6 +183,68 @@ RenderData Grid::calculate(const StyleContext &ctx, const Vector2D &surfaceSize,
       .position = box};
 }
 
+void Grid::calculateBatch(const StyleContext &ctx, StyleBatch &batch) const {
+  const int cols = (int)Config::gridColumns.value_or((float)columns);
+  const float spacing = Config::gridSpacing.value_or(0.0f) * ctx.scale;
+  const float topPadding = spacing > 0 ? spacing : ctx.mSize.y * 0.1f * ctx.scale;
+  const float gridW = ctx.mSize.x * Config::gridSize.value_or(0.8f);
+  const float slotW = (gridW - (spacing * (cols + 1))) / cols;
+  const float slotH = ctx.mSize.y * Config::GWSize.value_or(Config::windowSize);
+
+  const int activeRow = ctx.active / cols;
+  const float rowTop = activeRow * (slotH + spacing);
+  const float rowBottom = rowTop + slotH;
+  const float scrollOffset = (rowBottom > ctx.mSize.y) ? rowBottom - ctx.mSize.y : 0.0f;
+
+  const float activeScale = Config::GWSizeActive.value_or(Config::windowSizeActive);
+  const float inactiveScale = Config::GWSizeInactive.value_or(Config::windowSizeInactive);
+
+  const __m128 ZERO = _mm_setzero_ps();
+  const __m128 ONE = _mm_set1_ps(1.0f);
+  const __m128 HALF = _mm_set1_ps(0.5f);
+  const __m128 COLS = _mm_set1_ps((float)cols);
+  const __m128 ACTIVE = _mm_set1_ps((float)ctx.active);
+  const __m128 PROGRESS = _mm_set1_ps(ctx.activeProgress);
+  const __m128 INACTIVE_SCALE = _mm_set1_ps(inactiveScale);
+  const __m128 SCALE_RANGE = _mm_set1_ps(activeScale - inactiveScale);
+  const __m128 CTX_SCALE = _mm_set1_ps(ctx.scale);
+  const __m128 SLOT_W = _mm_set1_ps(slotW);
+  const __m128 SLOT_H = _mm_set1_ps(slotH);
+  const __m128 STRIDE_X = _mm_set1_ps(slotW + spacing);
+  const __m128 STRIDE_Y = _mm_set1_ps(slotH + spacing);
+  const __m128 ORIGIN_X = _mm_set1_ps((ctx.mSize.x - gridW) / 2.0f + spacing + slotW / 2.0f);
+  const __m128 ORIGIN_Y = _mm_set1_ps(topPadding - scrollOffset + slotH / 2.0f);
+  const __m128 UNFOCUSED = _mm_set1_ps(Config::unfocusedAlpha);
+  const __m128 ALPHA_RANGE = _mm_set1_ps(1.0f - Config::unfocusedAlpha);
+  const __m128 ALPHA = _mm_set1_ps(ctx.alpha);
+
+  for (size_t i = 0; i < batch.count; i += 4) {
+    const __m128 idx = _mm_loadu_ps(&batch.index[i]);
+    const __m128 row = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_div_ps(idx, COLS)));
+    const __m128 col = _mm_sub_ps(idx, _mm_mul_ps(row, COLS));
+
+    const __m128 isTarget = _mm_and_ps(_mm_cmpeq_ps(idx, ACTIVE), ONE);
+    const __m128 isActive = _mm_mul_ps(isTarget, PROGRESS);
+    const __m128 scale = _mm_mul_ps(_mm_add_ps(INACTIVE_SCALE, _mm_mul_ps(SCALE_RANGE, isActive)), CTX_SCALE);
+
+    const __m128 w = _mm_mul_ps(SLOT_W, scale);
+    const __m128 h = _mm_mul_ps(SLOT_H, scale);
+    const __m128 cx = _mm_add_ps(ORIGIN_X, _mm_mul_ps(col, STRIDE_X));
+    const __m128 cy = _mm_add_ps(ORIGIN_Y, _mm_mul_ps(row, STRIDE_Y));
+
+    const __m128 finalAlpha = _mm_mul_ps(_mm_add_ps(UNFOCUSED, _mm_mul_ps(ALPHA_RANGE, isActive)), ALPHA);
+
+    _mm_storeu_ps(&batch.x[i], _mm_sub_ps(cx, _mm_mul_ps(w, HALF)));
+    _mm_storeu_ps(&batch.y[i], _mm_sub_ps(cy, _mm_mul_ps(h, HALF)));
+    _mm_storeu_ps(&batch.w[i], w);
+    _mm_storeu_ps(&batch.h[i], h);
+    _mm_storeu_ps(&batch.z[i], isTarget);
+    _mm_storeu_ps(&batch.scale[i], scale);
+    _mm_storeu_ps(&batch.alpha[i], _mm_min_ps(_mm_max_ps(finalAlpha, ZERO), ONE));
+    _mm_storeu_ps(&batch.visible[i], _mm_and_ps(_mm_cmpgt_ps(finalAlpha, _mm_set1_ps(0.01f)), ONE));
+  }
+}
+
 MoveResult Grid::onMove(Direction dir, const size_t index, const size_t count) {
   if (count == 0)
     return {.changeMonitor = true};
@@ -198,6 +323,69 @@ RenderData Slide::calculate(const StyleContext &ctx, const Vector2D &surfaceSize
       .position = box};
 }
 
+void Slide::calculateBatch(const StyleContext &ctx, StyleBatch &batch) const {
+  const float baseSize = Config::slideSize.value_or(Config::windowSize);
+  const float activeMul = Config::slideSizeActive.value_or(Config::windowSizeActive);
+  const float activeH = ctx.mSize.y * activeMul * baseSize;
+  const float inactiveH = activeH * Config::slideSizeInactive.value_or(1.0f);
+  const float stripIndex = (ctx.rotation - (M_PI / 2.0f)) / (2.0f * M_PI) * ctx.count;
+  const float spacing = Config::slideSpacing.value_or(50.0f) * ctx.scale;
+
+  const __m128 ZERO = _mm_setzero_ps();
+  const __m128 ONE = _mm_set1_ps(1.0f);
+  const __m128 HALF = _mm_set1_ps(0.5f);
+  const __m128 HALF_COUNT = _mm_set1_ps((float)(ctx.count / 2));
+  const __m128 COUNT = _mm_set1_ps((float)ctx.count);
+  const __m128 STRIP = _mm_set1_ps(stripIndex);
+  const __m128 ABS_MASK = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+  const __m128 INACTIVE_H = _mm_set1_ps(inactiveH);
+  const __m128 ACTIVE_GAIN = _mm_set1_ps(activeMul - 1.0f);
+  const __m128 SCALE = _mm_set1_ps(ctx.scale / activeH);
+  const __m128 SPACING = _mm_set1_ps(spacing);
+  const __m128 CENTER_X = _mm_set1_ps(ctx.mSize.x / 2.0f);
+  const __m128 CENTER_Y = _mm_set1_ps(ctx.mSize.y / 2.0f);
+  const __m128 MON_W = _mm_set1_ps(ctx.mSize.x);
+  const __m128 MON_H = _mm_set1_ps(ctx.mSize.y);
+  const __m128 UNFOCUSED = _mm_set1_ps(Config::unfocusedAlpha);
+  const __m128 ALPHA_RANGE = _mm_set1_ps(1.0f - Config::unfocusedAlpha);
+  const __m128 ALPHA = _mm_set1_ps(ctx.alpha);
+
+  for (size_t i = 0; i < batch.count; i += 4) {
+    const __m128 idx = _mm_loadu_ps(&batch.index[i]);
+    const __m128 surfW = _mm_loadu_ps(&batch.width[i]);
+    const __m128 surfH = _mm_loadu_ps(&batch.height[i]);
+    const __m128 aspect = select_ps(_mm_cmpgt_ps(surfH, ZERO), _mm_div_ps(surfW, _mm_max_ps(surfH, _mm_set1_ps(1e-6f))), _mm_set1_ps(1.77f));
+
+    const __m128 slot = select_ps(_mm_cmpgt_ps(idx, HALF_COUNT), _mm_sub_ps(idx, COUNT), idx);
+    const __m128 diff = _mm_sub_ps(slot, STRIP);
+    const __m128 u = _mm_max_ps(ZERO, _mm_sub_ps(ONE, _mm_and_ps(diff, ABS_MASK)));
+    // u^2.5
+    const __m128 focusWeight = _mm_mul_ps(_mm_mul_ps(u, u), _mm_sqrt_ps(u));
+
+    const __m128 h = _mm_mul_ps(INACTIVE_H, _mm_add_ps(ONE, _mm_mul_ps(focusWeight, ACTIVE_GAIN)));
+    const __m128 w = _mm_mul_ps(h, aspect);
+    const __m128 slotWidth = _mm_add_ps(_mm_mul_ps(INACTIVE_H, aspect), SPACING);
+    const __m128 x = _mm_sub_ps(_mm_add_ps(CENTER_X, _mm_mul_ps(diff, slotWidth)), _mm_mul_ps(w, HALF));
+    const __m128 y = _mm_sub_ps(CENTER_Y, _mm_mul_ps(h, HALF));
+
+    const __m128 finalAlpha = _mm_mul_ps(_mm_add_ps(UNFOCUSED, _mm_mul_ps(ALPHA_RANGE, focusWeight)), ALPHA);
+    // Same test as CBox::overlaps against the monitor box
+    const __m128 overlaps = _mm_and_ps(
+        _mm_and_ps(_mm_cmpge_ps(MON_W, x), _mm_cmpge_ps(_mm_add_ps(x, w), ZERO)),
+        _mm_and_ps(_mm_cmpge_ps(MON_H, y), _mm_cmpge_ps(_mm_add_ps(y, h), ZERO)));
+    const __m128 visible = _mm_and_ps(_mm_cmpgt_ps(finalAlpha, _mm_set1_ps(0.01f)), overlaps);
+
+    _mm_storeu_ps(&batch.x[i], x);
+    _mm_storeu_ps(&batch.y[i], y);
+    _mm_storeu_ps(&batch.w[i], w);
+    _mm_storeu_ps(&batch.h[i], h);
+    _mm_storeu_ps(&batch.z[i], focusWeight);
+    _mm_storeu_ps(&batch.scale[i], _mm_mul_ps(h, SCALE));
+    _mm_storeu_ps(&batch.alpha[i], _mm_min_ps(_mm_max_ps(finalAlpha, ZERO), ONE));
+    _mm_storeu_ps(&batch.visible[i], _mm_and_ps(visible, ONE));
+  }
+}
+
 MoveResult Slide::onMove(Direction dir, const size_t index, const size_t count) {
   if (dir == Direction::UP || dir == Direction::DOWN)
     return {.changeMonitor = true};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "defines.hpp"
+#include <vector>
 
 struct StyleContext {
   size_t count;
@@ -24,6 +25,33 @@ struct RenderData {
   CBox position;
 };
 
+// Structure-of-arrays layout input/output for IStyle::calculateBatch.
+// Every array is padded to a multiple of 4 so kernels never need a scalar tail.
+struct StyleBatch {
+  size_t count = 0;
+  // in
+  std::vector<float> width, height, index;
+  // out
+  std::vector<float> x, y, w, h, z, scale, alpha, visible;
+
+  void resize(size_t n) {
+    count = n;
+    const size_t padded = (n + 3) & ~size_t(3);
+    for (auto *v : {&width, &height, &index, &x, &y, &w, &h, &z, &scale, &alpha, &visible})
+      v->resize(padded, 1.0f);
+  }
+
+  RenderData get(size_t i) const {
+    return {
+        .visible = visible[i] != 0.0f,
+        .z = z[i],
+        .rotation = 0.0f,
+        .scale = scale[i],
+        .alpha = alpha[i],
+        .position = {x[i], y[i], w[i], h[i]}};
+  }
+};
+
 struct MoveResult {
   bool changeMonitor = false;
   std::optional<size_t> index = std::nullopt;
@@ -33,18 +61,22 @@ class IStyle {
 public:
   virtual ~IStyle() = default;
   virtual RenderData calculate(const StyleContext &ctx, const Vector2D &surfaceSize, const size_t index) const = 0;
+  // Lays out batch.count cards at once. The default falls back to calculate(), which stays the reference.
+  virtual void calculateBatch(const StyleContext &ctx, StyleBatch &batch) const;
   virtual MoveResult onMove(Direction dir, const size_t index, const size_t count) = 0;
 };
 
 class Carousel : public IStyle {
 public:
   RenderData calculate(const StyleContext &ctx, const Vector2D &surfaceSize, const size_t index) const override;
+  void calculateBatch(const StyleContext &ctx, StyleBatch &batch) const override;
   MoveResult onMove(Direction dir, const size_t index, const size_t count) override;
 };
 
 class Grid : public IStyle {
 public:
   RenderData calculate(const StyleContext &ctx, const Vector2D &surfaceSize, const size_t index) const override;
+  void calculateBatch(const StyleContext &ctx, StyleBatch &batch) const override;
   MoveResult onMove(Direction dir, const size_t index, const size_t count) override;
 
 private:
@@ -54,5 +86,6 @@ private:
 class Slide : public IStyle {
 public:
   RenderData calculate(const StyleContext &ctx, const Vector2D &surfaceSize, const size_t index) const override;
+  void calculateBatch(const StyleContext &ctx, StyleBatch &batch) const override;
   MoveResult onMove(Direction dir, const size_t index, const size_t count) override;
 };